@@ -6,6 +6,7 @@
 #endif
 #include <cstddef>
 #include <map>
+#include <set>
 #include <unordered_set>
 
 namespace infini {
@@ -18,17 +19,27 @@ namespace infini {
 
     size_t peak;
 
+    // end of the last block in use, which freeing the tail moves down
+    size_t top;
+
+    // alignment of block offsets and sizes
     size_t alignment;
 
-    // pointer to the memory actually allocated
+    // alignment of the start of the memory, at least 'alignment'
+    size_t baseAlignment;
+
+    // pointer to the memory actually allocated, aligned to 'baseAlignment'
     void *ptr;
 
-    // =================================== 作业 ===================================
-    // TODO：可能需要设计一个数据结构来存储free block，以便于管理和合并
-    // HINT: 可以使用一个 map 来存储 free block，key 为 block 的起始/结尾地址，value 为 block 的大小
-    // =================================== 作业 ===================================
+    // the block returned by the runtime, which holds 'ptr'
+    void *block;
+
+    // blocks in use, offset -> size
     map<size_t, size_t> listAllocBlocks;
+    // free blocks below 'top', offset -> size, for coalescing with neighbors
     map<size_t, size_t> listFreeBlocks;
+    // the same free blocks as (size, offset), for best-fit lookup
+    std::set<std::pair<size_t, size_t>> freeBySize;
 
   public:
     Allocator(Runtime runtime);
@@ -51,11 +62,31 @@ namespace infini {
     // return: pointer to the head address of the allocated memory
     void *getPtr();
 
+    // function: print used and peak memory, and fragmentation of the free
+    // blocks below the top of the arena
     void info();
 
+    size_t getUsed() const { return used; }
+
+    size_t getPeak() const { return peak; }
+
+    size_t getAlignment() const { return alignment; }
+
+    // function: set the alignment of block offsets and sizes, a power of
+    // two, before anything is allocated
+    void setAlignment(size_t bytes);
+
+    // function: align the start of the memory getPtr() returns to at least
+    // 'bytes', a power of two, e.g. for offsets aligned beyond 'alignment'
+    void alignBase(size_t bytes);
+
   private:
     // function: memory alignment, rouned up
     // return: size of the aligned memory block
     size_t getAlignedSize(size_t size);
+
+    void insertFreeBlock(size_t addr, size_t size);
+
+    void eraseFreeBlock(map<size_t, size_t>::iterator it);
   };
 }
@@ -0,0 +1,96 @@
+#pragma once
+#include "core/graph.h"
+#include "core/plan.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <thread>
+
+namespace infini
+{
+
+    /**
+     * @brief Serves single-sample requests on a graph by coalescing them
+     * along the leading dim. A background thread collects up to maxBatch
+     * requests, waiting at most maxWait after the first one arrived, runs
+     * them as one execution of the graph and scatters the outputs back.
+     *
+     * The graph is built for one request and allocated. batchedInputs are
+     * the inputs filled per request; every other input (e.g. weights) is
+     * shared by all requests. Every operator has to treat the leading dim
+     * as a batch dim, so that a graph output of a batch of b requests is b
+     * outputs of one request stacked. A graph for each batch size is built
+     * on first use, re-running shape inference on the batched inputs.
+     */
+    class DynamicBatcher
+    {
+    public:
+        using Duration = std::chrono::microseconds;
+
+    private:
+        struct Request
+        {
+            vector<const void *> inputs;
+            vector<void *> outputs;
+            std::promise<void> done;
+        };
+
+        struct Batched
+        {
+            Graph graph;
+            TensorVec inputs, outputs;
+            ExecutionPlan plan;
+        };
+
+        Graph graph;
+        TensorVec batchedInputs, outputs;
+        std::map<int, Batched> batches; // by batch size
+
+        int maxBatch;
+        Duration maxWait;
+
+        std::mutex mutex;
+        std::condition_variable wakeUp;
+        std::deque<std::pair<Request, std::chrono::steady_clock::time_point>>
+            queue;
+        bool stopping = false;
+        std::thread worker;
+
+    public:
+        DynamicBatcher(Graph graph, TensorVec batchedInputs,
+                       int maxBatch = 8, Duration maxWait = Duration(1000));
+        /**
+         * @brief Serves the requests still queued, then stops.
+         */
+        ~DynamicBatcher();
+        DynamicBatcher(const DynamicBatcher &) = delete;
+        DynamicBatcher &operator=(const DynamicBatcher &) = delete;
+
+        /**
+         * @brief Queues a request. inputs[i] holds the data of
+         * batchedInputs[i] and outputs[j] receives the data of the j-th
+         * graph output; both must stay valid until the future is ready.
+         */
+        std::future<void> submit(vector<const void *> inputs,
+                                 vector<void *> outputs);
+
+        /**
+         * @brief Throughput against latency: larger batches make better
+         * use of the kernels, a longer wait fills them more often at the
+         * cost of the first request's latency.
+         */
+        void setMaxBatch(int n);
+        void setMaxWait(Duration wait);
+        int getMaxBatch() const { return maxBatch; }
+        Duration getMaxWait() const { return maxWait; }
+
+        const TensorVec &getOutputs() const { return outputs; }
+
+    private:
+        void workerLoop();
+        Batched &getBatched(int size);
+        void runBatch(vector<Request> &requests);
+    };
+
+} // namespace infini
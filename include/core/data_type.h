@@ -1,5 +1,6 @@
 #pragma once
 #include "core/common.h"
+#include <array>
 #include <cstdint>
 
 namespace infini {
@@ -101,4 +102,46 @@ template <> struct DT<12> { using t = uint32_t; };
 template <> struct DT<13> { using t = uint64_t; };
 template <> struct DT<16> { using t = uint16_t; };
 
+/**
+ * @brief The dtype indices a kernel is instantiated for.
+ */
+template <int... Ns> struct DTypeList {};
+
+// Dtypes whose DT<N>::t supports the arithmetic of the dtype itself.
+using NumericDTypes = DTypeList<1, 2, 3, 4, 5, 6, 7, 11, 12, 13>;
+// Every dtype with a fixed size, for kernels that only move elements.
+using AllDTypes = DTypeList<1, 2, 3, 4, 5, 6, 7, 9, 10, 11, 12, 13, 16>;
+
+namespace detail {
+constexpr int DTYPE_COUNT = std::size(DataType::sizePerElement);
+
+// A table from dtype index to f(DT<N>{}), filled at compile time.
+template <typename F, int... Ns> struct DTypeTable {
+    using Thunk = void (*)(F &);
+    template <int N> static void call(F &f) { f(DT<N>{}); }
+    static constexpr std::array<Thunk, DTYPE_COUNT> make() {
+        std::array<Thunk, DTYPE_COUNT> table{};
+        ((table[Ns] = &call<Ns>), ...);
+        return table;
+    }
+    static constexpr std::array<Thunk, DTYPE_COUNT> table = make();
+};
+} // namespace detail
+
+/**
+ * @brief Calls f(DT<N>{}) for N = dtype.getIndex(), where f is usually a
+ * generic lambda instantiating a kernel for typename decltype(tag)::t. f is
+ * instantiated for every dtype of the list and the call is a single table
+ * lookup; dtypes outside the list halt.
+ */
+template <int... Ns, typename F>
+void dispatchDType(DTypeList<Ns...>, DataType dtype, F &&f) {
+    using Table = detail::DTypeTable<std::remove_reference_t<F>, Ns...>;
+    const int index = dtype.getIndex();
+    IT_ASSERT(index >= 0 && index < detail::DTYPE_COUNT &&
+                  Table::table[index] != nullptr,
+              "Unsupported data type " + dtype.toString());
+    Table::table[index](f);
+}
+
 } // namespace infini
@@ -1,5 +1,7 @@
 #pragma once
 #include "core/allocator.h"
+#include "core/memory_planner.h"
+#include "core/memory_report.h"
 #include "core/operator.h"
 #include "core/tensor.h"
 
@@ -16,6 +18,16 @@ namespace infini
         TensorVec tensors;
         OpVec ops;
         Allocator allocator;
+        TensorVec externals; // bound to caller-owned memory
+        MemoryPlanner::Plan memoryPlan;
+        MemoryReport memoryReport;
+        // tensors aligned beyond the allocator's alignment
+        unordered_map<const TensorObj *, size_t> alignments;
+        size_t rowAlignment = 0; // bytes, 0 for dense rows
+        // earlier ops using memory an op writes, see dataMalloc()
+        unordered_map<const OperatorObj *, OpVec> memoryDeps;
+        // ops whose output dataMalloc() made a view of their input
+        std::set<const OperatorObj *> viewOps;
 
     public:
         explicit GraphObj(Runtime runtime)
@@ -38,6 +50,7 @@ namespace infini
             auto it = std::find(tensors.begin(), tensors.end(), tensor);
             if (it != tensors.end())
                 tensors.erase(it);
+            alignments.erase(tensor.get());
         }
 
         const TensorVec &getTensors() const { return tensors; }
@@ -56,8 +69,86 @@ namespace infini
 
         void shape_infer();
 
+        /**
+         * @brief Places every tensor in one arena by its lifetime over the
+         * sorted operators, see MemoryPlanner. Graph inputs and outputs
+         * live for the whole run.
+         */
         void dataMalloc();
 
+        /**
+         * @brief The placement of the last dataMalloc(), with the arena
+         * size it achieved and the lower bound for it.
+         */
+        const MemoryPlanner::Plan &getMemoryPlan() const
+        {
+            return memoryPlan;
+        }
+
+        /**
+         * @brief Where the last dataMalloc() placed every tensor, with the
+         * utilization of the arena over the operators.
+         */
+        const MemoryReport &getMemoryReport() const { return memoryReport; }
+
+        /**
+         * @brief The earlier operators that op has to wait for besides its
+         * predecessors, as it writes memory that dataMalloc() reused from
+         * tensors they read or write.
+         */
+        const OpVec &getMemoryDependencies(const Operator &op) const;
+        /**
+         * @brief Whether dataMalloc() made the output of op, a Transpose, a
+         * view of its input. Such an op computes nothing and is not run.
+         */
+        bool isView(const Operator &op) const
+        {
+            return viewOps.count(op.get()) > 0;
+        }
+
+        /**
+         * @brief Alignment of the tensors dataMalloc() places, a power of
+         * two. It defaults to 64 bytes, a cache line.
+         */
+        void setMemoryAlignment(size_t bytes) { allocator.setAlignment(bytes); }
+        size_t getMemoryAlignment() const { return allocator.getAlignment(); }
+        /**
+         * @brief Pads the rows of the intermediate matrices that are
+         * written and read only by stride-aware kernels, e.g. between two
+         * MatMuls, so that every row starts on a multiple of bytes, a power
+         * of two, for GEMM packing. 0, the default, keeps rows dense.
+         */
+        void setRowAlignment(size_t bytes);
+        size_t getRowAlignment() const { return rowAlignment; }
+        /**
+         * @brief Aligns one tensor beyond the memory alignment, e.g. a
+         * large weight to a page.
+         */
+        void setAlignment(const Tensor &tensor, size_t bytes);
+        // 0 when tensor has none of its own.
+        size_t getAlignment(const Tensor &tensor) const
+        {
+            auto it = alignments.find(tensor.get());
+            return it != alignments.end() ? it->second : 0;
+        }
+
+        /**
+         * @brief Leaves a graph input or output out of the memory dataMalloc()
+         * allocates: its data is a caller-owned buffer bound with
+         * bindExternal(), or with ExecutionPlanObj::bind() for a plan, so
+         * it is never copied. Must be called before dataMalloc().
+         */
+        void setExternal(const Tensor &tensor);
+        bool isExternal(const Tensor &tensor) const;
+        const TensorVec &getExternals() const { return externals; }
+        /**
+         * @brief Binds ptr, aligned to the tensor's element size and
+         * holding getBytes() bytes, as the data of an external tensor until
+         * the next binding. The caller keeps ownership.
+         */
+        void bindExternal(const Tensor &tensor, void *ptr);
+        void checkExternal(const Tensor &tensor, const void *ptr) const;
+
         /**
          * @brief Add an operator and create its outputs. Output tensor arguments
          * should be empty Refs (e.g., nullptr).
@@ -70,6 +161,13 @@ namespace infini
             return op;
         }
 
+        /**
+         * @brief Add a copy of op, an operator of any graph, reading the
+         * given tensors of this graph. The outputs are created with the
+         * shapes and dtypes inferred from these inputs.
+         */
+        Operator cloneOperator(const Operator &op, const TensorVec &inputs);
+
         /**
          * @brief Add an operator with its outputs specified.
          */
@@ -122,6 +220,10 @@ namespace infini
         void shortcutOperatorLink(const Operator &from, const Operator &to);
         void eliminateOperNode(const Operator &op);
         void skimOffTensors();
+        /**
+         * @brief Fills memoryDeps from the data blobs set by dataMalloc().
+         */
+        void findMemoryDependencies();
 
         /**
          * @brief If the nodes is sorted in topological order.
@@ -1,6 +1,7 @@
 #pragma once
 #include "core/common.h"
 #include "core/operator.h"
+#include "core/runtime.h"
 #include "core/tensor.h"
 #include "utils/operator_utils.h"
 #include <functional>
@@ -10,6 +11,18 @@ namespace infini
 
     class RuntimeObj;
 
+    /**
+     * @brief What a kernel precomputes for one op so that executing it
+     * needs no lookups: raw data pointers, reduced shapes and strides,
+     * resolved function pointers. Valid while the op's tensors keep their
+     * shapes and data blobs.
+     */
+    class KernelParams
+    {
+    public:
+        virtual ~KernelParams() {}
+    };
+
     class Kernel
     {
     public:
@@ -21,47 +34,129 @@ namespace infini
          */
         virtual void compute(const Operator &op,
                              const RuntimeObj *context) const = 0;
+        /**
+         * @brief Precomputes the parameters of op for execute(). Kernels
+         * without a prepared path return nullptr and are run by compute().
+         */
+        virtual std::unique_ptr<KernelParams>
+        prepare(const Operator &op, const RuntimeObj *context) const
+        {
+            return nullptr;
+        }
+        /**
+         * @brief Executes with parameters returned by prepare().
+         */
+        virtual void execute(const KernelParams &params,
+                             const RuntimeObj *context) const
+        {
+            IT_TODO_HALT();
+        }
+        /**
+         * @brief Whether the output of op may be written over its input-th
+         * input, see GraphObj::dataMalloc(). Kernels that read every
+         * element before writing the element at the same position return
+         * sameLayout(op, input).
+         */
+        virtual bool supportsInPlace(const Operator &op, int input) const
+        {
+            return false;
+        }
+        /**
+         * @brief Whether the input-th input of op may be a strided view
+         * (TensorObj::getStrides()), which lets dataMalloc() turn the
+         * Transpose producing it into a view of its input instead of a
+         * copy.
+         */
+        virtual bool supportsStrides(const Operator &op, int input) const
+        {
+            return false;
+        }
+        /**
+         * @brief Whether the output of op is written through its strides,
+         * which lets dataMalloc() pad its rows, see
+         * GraphObj::setRowAlignment().
+         */
+        virtual bool supportsOutputStrides(const Operator &op) const
+        {
+            return false;
+        }
+
+    protected:
+        /**
+         * @brief Whether the output of op and its input-th input have the
+         * same shape, strides and element size, so that elements line up.
+         */
+        static bool sameLayout(const Operator &op, int input)
+        {
+            auto in = op->getInputs(input), out = op->getOutput();
+            return in->getDims() == out->getDims() &&
+                   in->getStrides() == out->getStrides() &&
+                   in->getDType().getSize() == out->getDType().getSize();
+        }
     };
 
+    /**
+     * @brief Holds the candidate kernels of every KernelAttrs, ordered by
+     * rank. The highest ranked candidate is the default one; KernelTuner
+     * may pick another after measuring them.
+     */
     class KernelRegistry
     {
     public:
         using KernelRecord =
-            tuple<Kernel *const, const string, const int>; // Kernel, name, ID
+            tuple<Kernel *, string, int, int>; // Kernel, name, ID, rank
 
     private:
-        std::map<KernelAttrs, KernelRecord> kernels;
+        std::map<KernelAttrs, vector<KernelRecord>> kernels;
         int nKernels = 0;
 
     public:
         ~KernelRegistry()
         {
-            for (auto &[k, v] : kernels)
-                delete std::get<0>(v);
+            for (auto &[k, records] : kernels)
+                for (auto &v : records)
+                    delete std::get<0>(v);
         }
         static KernelRegistry &getInstance()
         {
             static KernelRegistry instance;
             return instance;
         }
-        bool registerKernel(const KernelAttrs &key, Kernel *kernel, string name)
+        bool registerKernel(const KernelAttrs &key, Kernel *kernel, string name,
+                            int rank = 0)
         {
-            IT_ASSERT(kernels.find(key) == kernels.end(),
-                      "Kernel already registered");
-            kernels.emplace(key, KernelRecord{kernel, name, ++nKernels});
+            auto &records = kernels[key];
+            for (auto &v : records)
+                IT_ASSERT(std::get<1>(v) != name, "Kernel already registered");
+            auto pos = std::find_if(records.begin(), records.end(),
+                                    [&](const KernelRecord &v)
+                                    { return std::get<3>(v) < rank; });
+            records.emplace(pos, kernel, name, ++nKernels, rank);
             return true;
         }
+        bool hasKernel(const KernelAttrs &kernelAttrs) const
+        {
+            return kernels.count(kernelAttrs) > 0;
+        }
         Kernel *getKernel(const KernelAttrs &kernelAttrs) const
+        {
+            return std::get<0>(getKernelItem(kernelAttrs));
+        }
+        const KernelRecord &getKernelItem(const KernelAttrs &kernelAttrs) const
+        {
+            return getKernelItems(kernelAttrs).front();
+        }
+        /**
+         * @brief All candidates for kernelAttrs, highest rank first.
+         */
+        const vector<KernelRecord> &
+        getKernelItems(const KernelAttrs &kernelAttrs) const
         {
             auto it = kernels.find(kernelAttrs);
             IT_ASSERT(it != kernels.end(), "Kernel not found for key {" +
                                                get_kernel_attrs_str(kernelAttrs) +
                                                "}");
-            return std::get<0>(it->second);
-        }
-        const KernelRecord &getKernelItem(const KernelAttrs &kernelAttrs) const
-        {
-            return kernels.at(kernelAttrs);
+            return it->second;
         }
     };
 
@@ -70,18 +165,53 @@ namespace infini
     public:
         virtual void compute(const Operator &op,
                              const RuntimeObj *context) const = 0;
+
+    protected:
+        /**
+         * @brief Threads to split about `work` bytes of work over, following
+         * the policy of the runtime (see NativeCpuRuntimeObj::setNumThreads).
+         */
+        static int getNumThreads(const RuntimeObj *context, size_t work)
+        {
+            return static_cast<const NativeCpuRuntimeObj *>(context)
+                ->getTaskThreads(work);
+        }
+    };
+
+    /**
+     * @brief A CPU kernel split into prepare(), resolving everything that
+     * only depends on the op, and execute(). compute() does both.
+     */
+    class CpuKernelWithParams : public CpuKernelWithoutConfig
+    {
+    public:
+        void compute(const Operator &op,
+                     const RuntimeObj *context) const override
+        {
+            execute(*prepare(op, context), context);
+        }
+        std::unique_ptr<KernelParams>
+        prepare(const Operator &op, const RuntimeObj *context) const override = 0;
+        void execute(const KernelParams &params,
+                     const RuntimeObj *context) const override = 0;
     };
 
 } // namespace infini
 
-#define _REGISTER_KERNEL_1(device, opType, kernel, name, cnt)                 \
+#define _REGISTER_KERNEL_IMPL(device, opType, kernel, name, rank, cnt)       \
     namespace infini                                                          \
     {                                                                         \
         static const bool _CAT(_register_kernel_, cnt) =                      \
-            KernelRegistry::getInstance().registerKernel(KernelAttrs{device,  \
-                                                                     opType}, \
-                                                         new kernel(), name); \
+            KernelRegistry::getInstance().registerKernel(                     \
+                KernelAttrs{device, opType}, new kernel(), name, rank);       \
     }
 
-#define REGISTER_KERNEL(device, opType, kernel, name) \
-    _REGISTER_KERNEL_1(device, opType, kernel, name, __COUNTER__)
+#define _REGISTER_KERNEL_4(device, opType, kernel, name)                      \
+    _REGISTER_KERNEL_IMPL(device, opType, kernel, name, 0, __COUNTER__)
+#define _REGISTER_KERNEL_5(device, opType, kernel, name, rank)                \
+    _REGISTER_KERNEL_IMPL(device, opType, kernel, name, rank, __COUNTER__)
+
+// REGISTER_KERNEL(device, opType, kernel, name[, rank]): registers a
+// candidate kernel. Candidates with a higher rank are preferred, the default
+// rank is 0.
+#define REGISTER_KERNEL(...) _VA_SELECT(_REGISTER_KERNEL, __VA_ARGS__)
@@ -0,0 +1,57 @@
+#pragma once
+#include "core/kernel.h"
+#include <mutex>
+
+namespace infini
+{
+
+    /**
+     * @brief Picks the fastest registered candidate for an operator by
+     * timing every candidate on copies of its tensors. Decisions are keyed by
+     * op type, shapes and dtypes, kept in memory and, when a cache file is
+     * set, appended to it so later processes skip re-tuning.
+     */
+    class KernelTuner
+    {
+        std::map<string, string> decisions; // key -> kernel name
+        string cacheFile;
+        mutable std::mutex mutex;
+
+    public:
+        static KernelTuner &getInstance()
+        {
+            static KernelTuner instance;
+            return instance;
+        }
+
+        /**
+         * @brief Loads the decisions recorded in path, if it exists, and
+         * records new decisions there.
+         */
+        void setCacheFile(const string &path);
+        const string &getCacheFile() const { return cacheFile; }
+        /**
+         * @brief Drops all in-memory decisions. The cache file is kept.
+         */
+        void clear();
+
+        /**
+         * @brief Returns the tuned kernel for op, timing the candidates on
+         * the first call for its key. Candidates that throw (e.g. for an
+         * unsupported dtype) are skipped.
+         */
+        Kernel *getKernel(const Operator &op, const RuntimeObj *context);
+        /**
+         * @brief Name of the kernel chosen for op, if it was tuned.
+         */
+        optional<string> getDecision(const Operator &op) const;
+
+        static string getKey(const Operator &op);
+
+    private:
+        KernelTuner() = default;
+        const KernelRegistry::KernelRecord &
+        tune(const Operator &op, const RuntimeObj *context) const;
+    };
+
+} // namespace infini
@@ -0,0 +1,62 @@
+#pragma once
+#include "core/common.h"
+
+namespace infini
+{
+
+    /**
+     * @brief Offline placement of tensors with known lifetimes in a single
+     * arena. Every tensor is live over an inclusive interval of operator
+     * steps; tensors whose intervals overlap get disjoint byte ranges.
+     * Several heuristics are tried and the smallest arena is kept,
+     * reported next to the lower bound no placement can beat: the largest
+     * total size of the tensors live at one step.
+     *
+     * A tensor may name an earlier one to alias, i.e. to be computed in
+     * place over it. It does so when the earlier one is last used at the
+     * step the tensor is first used, by the op computing it; both are
+     * then placed at one offset, as one interval.
+     */
+    class MemoryPlanner
+    {
+    public:
+        enum class Strategy
+        {
+            GreedyBySize,     // largest tensors first, best-fit gaps
+            GreedyByBreadth,  // tensors of the busiest steps first
+            IntervalColoring, // by first use, lowest free offset
+        };
+
+        struct Interval
+        {
+            size_t begin, end; // first and last step using the tensor
+            size_t size;
+            int alias = -1; // index of the interval to compute in place over
+            size_t alignment = 0; // of the offset, 0 for that of the plan
+        };
+
+        struct Plan
+        {
+            vector<size_t> offsets; // per interval
+            size_t arena = 0;
+            size_t lowerBound = 0;
+            Strategy strategy = Strategy::GreedyBySize;
+
+            string toString() const;
+        };
+
+        /**
+         * @brief The best plan over all strategies. Sizes are padded to
+         * `alignment`, a power of two, and offsets are aligned to it or to
+         * the larger alignment of their interval.
+         */
+        static Plan plan(const vector<Interval> &intervals,
+                         size_t alignment);
+        static Plan plan(const vector<Interval> &intervals, size_t alignment,
+                         Strategy strategy);
+        static size_t lowerBound(const vector<Interval> &intervals,
+                                 size_t alignment);
+        static string toString(Strategy strategy);
+    };
+
+} // namespace infini
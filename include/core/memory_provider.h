@@ -0,0 +1,75 @@
+#pragma once
+#include "core/common.h"
+#include <mutex>
+#include <unordered_map>
+
+namespace infini
+{
+
+    enum class HugePages
+    {
+        None,        // regular pages
+        Transparent, // madvise(MADV_HUGEPAGE), left to the kernel
+        Explicit,    // MAP_HUGETLB from the reserved huge page pool
+    };
+
+    /**
+     * @brief Host memory behind NativeCpuRuntimeObj::alloc(). Blocks are
+     * aligned to `alignment` bytes and not zeroed. Blocks of at least
+     * HUGE_PAGE bytes are mapped with huge pages as configured, falling
+     * back to transparent and then regular pages; getPageMode() tells
+     * what a block actually got.
+     *
+     * With a NUMA node set, blocks are mapped and their pages bound to
+     * that node, so they are placed there whichever thread touches them
+     * first.
+     */
+    class MemoryProvider
+    {
+    public:
+        static constexpr size_t HUGE_PAGE = 2 << 20;
+
+    private:
+        struct Block
+        {
+            size_t bytes; // mapped bytes, 0 for heap blocks
+            HugePages mode;
+            int node;     // -1 when not bound
+            size_t size;  // requested bytes
+        };
+
+        size_t alignment = 64;
+        HugePages hugePages = HugePages::None;
+        int node = -1;
+        mutable std::mutex mutex;
+        std::unordered_map<void *, Block> blocks;
+
+    public:
+        /**
+         * @brief Alignment of new blocks, a power of two.
+         */
+        void setAlignment(size_t bytes);
+        size_t getAlignment() const { return alignment; }
+        void setHugePages(HugePages mode) { hugePages = mode; }
+        HugePages getHugePages() const { return hugePages; }
+        /**
+         * @brief NUMA node new blocks are bound to, -1 for none.
+         */
+        void setNode(int node);
+        int getNode() const { return node; }
+
+        void *alloc(size_t size);
+        void dealloc(void *ptr);
+        HugePages getPageMode(void *ptr) const;
+        int getNode(void *ptr) const;
+        /**
+         * @brief Bytes of live blocks per NUMA node; blocks not bound to a
+         * node are counted under -1.
+         */
+        std::map<int, size_t> getNodeUsage() const;
+
+    private:
+        void *mapPages(size_t bytes, HugePages &mode);
+    };
+
+} // namespace infini
@@ -0,0 +1,98 @@
+#pragma once
+#include "core/object.h"
+#include <ostream>
+
+namespace infini
+{
+
+    /**
+     * @brief Where dataMalloc() placed every tensor and how full the arena
+     * is over the steps of the sorted operators. The step with the most
+     * live bytes is the peak; the tensors live there, and the op run
+     * there, are what drive the arena size. Exported as JSON or CSV, and
+     * rendered as an ASCII or SVG memory map with the arena offsets across
+     * and the steps down.
+     */
+    class MemoryReport
+    {
+    public:
+        struct Allocation
+        {
+            UidBaseType fuid;
+            size_t offset, size; // in the arena, padded
+            size_t begin, end;   // first and last step using the tensor
+            string producer;     // op computing it, empty for graph inputs
+        };
+
+        struct Step
+        {
+            string op;
+            size_t live;   // bytes of the tensors live at the step
+            size_t extent; // end of the highest of those tensors
+        };
+
+    private:
+        vector<Allocation> allocations;
+        vector<Step> steps;
+        size_t arena = 0, lowerBound = 0;
+
+    public:
+        MemoryReport() = default;
+        /**
+         * @brief ops names the op run at every step.
+         */
+        MemoryReport(vector<Allocation> allocations, vector<string> ops,
+                     size_t arena, size_t lowerBound);
+
+        const vector<Allocation> &getAllocations() const
+        {
+            return allocations;
+        }
+        const vector<Step> &getSteps() const { return steps; }
+        size_t getArena() const { return arena; }
+        size_t getLowerBound() const { return lowerBound; }
+        /**
+         * @brief The first step with the most live bytes.
+         */
+        size_t getPeakStep() const;
+        /**
+         * @brief The allocations live at the peak step, largest first.
+         */
+        vector<Allocation> getPeakAllocations() const;
+        /**
+         * @brief The share of the arena not used even at the peak step.
+         */
+        double getFragmentation() const;
+
+        /**
+         * @brief Arena, lower bound, fragmentation and the peak step with
+         * its largest tensors.
+         */
+        string summary() const;
+        /**
+         * @brief Everything above: allocations, the utilization curve and
+         * the peak with the fuids of its tensors.
+         */
+        void dumpJson(std::ostream &os) const;
+        void dumpJson(const string &path) const;
+        /**
+         * @brief One row per allocation.
+         */
+        void dumpCsv(std::ostream &os) const;
+        void dumpCsv(const string &path) const;
+        /**
+         * @brief One row per step of the utilization curve.
+         */
+        void dumpUtilizationCsv(std::ostream &os) const;
+        void dumpUtilizationCsv(const string &path) const;
+        /**
+         * @brief One line per step, the arena scaled to `width` columns:
+         * '.' is free and every tensor has a letter, listed below the map.
+         * The peak step is marked with '*'.
+         */
+        string renderAscii(size_t width = 64) const;
+        void renderSvg(std::ostream &os) const;
+        void renderSvg(const string &path) const;
+    };
+
+} // namespace infini
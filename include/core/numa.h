@@ -0,0 +1,42 @@
+#pragma once
+#include "core/common.h"
+
+namespace infini
+{
+
+    /**
+     * @brief NUMA nodes of the host and their CPUs, read from sysfs once.
+     * Hosts without NUMA information are a single node with every CPU.
+     */
+    class NumaTopology
+    {
+        vector<vector<int>> nodeCpus;
+        vector<int> processCpus;
+
+        NumaTopology();
+
+    public:
+        static const NumaTopology &getInstance();
+
+        int numNodes() const { return nodeCpus.size(); }
+        const vector<int> &getCpus(int node) const { return nodeCpus.at(node); }
+        int getNodeOfCpu(int cpu) const;
+        /**
+         * @brief The affinity of the process when the topology was first
+         * read, e.g. as set by taskset or a cpuset; every CPU when unknown.
+         */
+        const vector<int> &getProcessCpus() const { return processCpus; }
+
+        /**
+         * @brief Restricts the physical pages of [ptr, ptr + bytes), which
+         * must be page aligned and not yet touched, to node. Returns false
+         * when the kernel refuses.
+         */
+        static bool bindMemory(void *ptr, size_t bytes, int node);
+        /**
+         * @brief Pins the calling thread to cpus. Returns false on failure.
+         */
+        static bool pinThread(const vector<int> &cpus);
+    };
+
+} // namespace infini
@@ -54,6 +54,11 @@ namespace infini
         DataType getOutDType() const { return getOutput()->getDType(); }
         virtual int numInputs() const = 0;
         virtual int numOutputs() const = 0;
+        /**
+         * @brief Arithmetic operations of one execution, 0 for operators
+         * that only move data.
+         */
+        virtual size_t getFlops() const { return 0; }
 
         /**
          * @brief Clone this operator and replace its inputs and outputs.
@@ -0,0 +1,86 @@
+#pragma once
+#include "core/graph.h"
+#include "core/kernel.h"
+#include <mutex>
+
+namespace infini
+{
+
+    /**
+     * @brief A graph compiled for repeated execution: a flat array with the
+     * resolved kernel and prepared parameters of every operator but the
+     * views (GraphObj::isView), in topological order, which
+     * NativeCpuRuntimeObj::run(plan) walks.
+     *
+     * The parameters hold raw data pointers and precomputed shapes, so a
+     * plan is built after dataMalloc() and has to be compiled again once
+     * the graph, a tensor shape or a data blob changes.
+     *
+     * A plan compiled with its own memory computes its activations, the
+     * tensors produced by an op, in private memory reached through
+     * getData(), so several plans of one graph can be in flight at once.
+     * Weights and other graph inputs are read from the graph's data and
+     * shared; per-request inputs are external tensors bound with bind().
+     * A single plan runs one request at a time.
+     *
+     * External tensors of the graph (GraphObj::setExternal) are bound per
+     * plan with bind(); the entries reading or writing them are prepared
+     * again on the next run.
+     */
+    class ExecutionPlanObj
+    {
+    public:
+        struct Entry
+        {
+            Operator op;
+            Kernel *kernel;
+            // Null for kernels without a prepared path, which are run
+            // with compute() on the plan's data (TensorObj::DataScope).
+            std::unique_ptr<KernelParams> params;
+            // An external tensor of op was rebound since prepare().
+            bool stale = false;
+        };
+
+    private:
+        friend class NativeCpuRuntimeObj;
+
+        Graph graph; // keeps the tensors and their blobs alive
+        vector<Entry> entries;
+        std::shared_ptr<void> memory; // private tensor memory, if any
+        std::map<const TensorObj *, void *> data;
+        bool stale = false; // some entry is stale
+        mutable std::mutex running;
+
+    public:
+        ExecutionPlanObj(Graph graph, vector<Entry> entries,
+                         std::shared_ptr<void> memory,
+                         std::map<const TensorObj *, void *> data)
+            : graph(std::move(graph)), entries(std::move(entries)),
+              memory(std::move(memory)), data(std::move(data)) {}
+
+        /**
+         * @brief Data of a graph tensor as seen by this plan.
+         */
+        template <typename T>
+        T getData(const Tensor &tensor) const
+        {
+            static_assert(std::is_pointer_v<T>,
+                          "Raw data pointer has a type of pointer");
+            auto it = data.find(tensor.get());
+            IT_ASSERT(it != data.end(), "Tensor is not in the plan's graph");
+            return static_cast<T>(it->second);
+        }
+        bool hasOwnMemory() const { return memory != nullptr; }
+        /**
+         * @brief Binds a caller-owned buffer as the data of an external
+         * tensor for the following runs of this plan. Waits for a run in
+         * progress.
+         */
+        void bind(const Tensor &tensor, void *ptr);
+
+        const vector<Entry> &getEntries() const { return entries; }
+        size_t size() const { return entries.size(); }
+        const Graph &getGraph() const { return graph; }
+    };
+
+} // namespace infini
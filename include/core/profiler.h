@@ -0,0 +1,64 @@
+#pragma once
+#include "core/operator.h"
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+namespace infini
+{
+
+    /**
+     * @brief Collects one record per executed operator while profiling is
+     * enabled on the runtime (NativeCpuRuntimeObj::setProfiling). Records
+     * can be summed up per op type and shape or exported as a Chrome trace,
+     * which chrome://tracing and Perfetto open.
+     */
+    class Profiler
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        struct Record
+        {
+            string name;      // op type
+            string key;       // op type, dtypes and shapes
+            int thread;       // index of the thread, in order of appearance
+            double start;     // us since the profiler was created or cleared
+            double duration;  // us
+            size_t flops;
+            size_t bytesRead; // all inputs
+            size_t bytesWritten;
+        };
+
+    private:
+        mutable std::mutex mutex;
+        Clock::time_point epoch;
+        vector<Record> records;
+        std::map<std::thread::id, int> threads;
+
+    public:
+        Profiler() : epoch(Clock::now()) {}
+
+        /**
+         * @brief Records op as run on the calling thread in [begin, end).
+         */
+        void record(const Operator &op, Clock::time_point begin,
+                    Clock::time_point end);
+        void clear();
+        vector<Record> getRecords() const;
+
+        /**
+         * @brief Writes the records in the Chrome trace event format, one
+         * complete event per op.
+         */
+        void dumpChromeTrace(std::ostream &os) const;
+        void dumpChromeTrace(const string &path) const;
+        /**
+         * @brief A table with one row per op type and shape: calls, total
+         * and mean time, share of the total, GFLOP/s and GB/s, sorted by
+         * total time.
+         */
+        string summary() const;
+    };
+
+} // namespace infini
@@ -1,7 +1,11 @@
 #pragma once
 #include "core/common.h"
+#include "core/memory_provider.h"
 #include "core/op_type.h"
 #include "core/ref.h"
+#include <atomic>
+#include <future>
+#include <mutex>
 
 namespace infini
 {
@@ -10,8 +14,13 @@ namespace infini
   class GraphObj;
   class RuntimeObj;
   class BlobObj;
+  class ThreadPool;
+  class Kernel;
   class OptimizeContextObj;
   class OptimizerObj;
+  class ExecutionPlanObj;
+  class KernelParams;
+  class Profiler;
 
   using Tensor = Ref<TensorObj>;
   using Operator = Ref<OperatorObj>;
@@ -24,6 +33,7 @@ namespace infini
 
   using OptimizeContext = Ref<OptimizeContextObj>;
   using Optimizer = Ref<OptimizerObj>;
+  using ExecutionPlan = Ref<ExecutionPlanObj>;
 
   enum class Device
   {
@@ -51,11 +61,33 @@ namespace infini
       return true;
     }
 
+    Device getDevice() const { return device; }
+
     virtual string toString() const = 0;
   };
 
   class NativeCpuRuntimeObj : public RuntimeObj
   {
+    bool autotune = false;
+    int numThreads = 0;         // 0: the OpenMP default
+    size_t grainSize = 1 << 16; // bytes
+    int interOpThreads = 1;
+    std::shared_ptr<ThreadPool> pool; // for interOpThreads > 1
+    std::shared_ptr<MemoryProvider> memory =
+        std::make_shared<MemoryProvider>();
+    bool profiling = false;
+    std::shared_ptr<Profiler> profiler;
+    int asyncThreads = 1;
+    int numaNode = -1;
+    bool pinThreads = false;
+    // Set to a new process-wide generation when pinning changes, 0 until
+    // then.
+    std::atomic<int> pinGeneration{0};
+    mutable std::mutex asyncMutex;
+    // Created on the first runAsync(); declared last so that it drains
+    // before the other members are destroyed.
+    mutable std::shared_ptr<ThreadPool> asyncPool;
+
   public:
     NativeCpuRuntimeObj() : RuntimeObj(Device::CPU) {}
 
@@ -66,7 +98,102 @@ namespace infini
       return instance;
     }
     void dealloc(void *ptr) override;
+    /**
+     * @brief Alignment and huge page options of alloc(), which also backs
+     * the graph arenas and the private memory of plans.
+     */
+    MemoryProvider &getMemoryProvider() const { return *memory; }
     void run(const Graph &graph) const override;
+    /**
+     * @brief Resolves the kernel of every operator of an allocated graph,
+     * autotuning if enabled, and prepares its parameters once so that
+     * run(plan) executes without lookups. See ExecutionPlanObj.
+     */
+    ExecutionPlan compile(const Graph &graph, bool ownMemory = false) const;
+    void run(const ExecutionPlan &plan) const;
+    /**
+     * @brief Queues plan on the async threads and returns at once. Plans
+     * compiled with their own memory let requests overlap: while one runs,
+     * the inputs of the next can be bound and the outputs of the last
+     * read. Kernel errors are rethrown by the future's get().
+     */
+    std::future<void> runAsync(const ExecutionPlan &plan) const;
+    /**
+     * @brief Threads serving runAsync(), 1 by default. The intra-op thread
+     * budget is split between them. Must not be changed while requests
+     * are in flight.
+     */
+    void setAsyncThreads(int n);
+    int getAsyncThreads() const { return asyncThreads; }
+    /**
+     * @brief When enabled, run() uses the kernel KernelTuner measured to be
+     * the fastest for each op instead of the highest ranked one.
+     */
+    void setAutotune(bool enable) { autotune = enable; }
+    bool getAutotune() const { return autotune; }
+    /**
+     * @brief Intra-op parallelism policy: a kernel splits an op over at
+     * most numThreads threads (0 uses the OpenMP default) and gives each of
+     * them at least grainSize bytes of work, so small tensors stay
+     * single-threaded.
+     */
+    void setNumThreads(int n);
+    void setGrainSize(size_t bytes);
+    int getNumThreads() const;
+    size_t getGrainSize() const { return grainSize; }
+    /**
+     * @brief Threads to use for an op processing about `work` bytes. When
+     * operators run concurrently the thread budget is split between them.
+     */
+    int getTaskThreads(size_t work) const;
+    /**
+     * @brief With n > 1, run() schedules every operator as soon as its
+     * predecessors are done onto a work-stealing pool of n threads, so
+     * independent branches overlap. n = 1, the default, runs them in order.
+     */
+    void setInterOpThreads(int n);
+    int getInterOpThreads() const { return interOpThreads; }
+    /**
+     * @brief While enabled, every operator run is timed and recorded in
+     * getProfiler(). Disabling keeps the records collected so far.
+     */
+    void setProfiling(bool enable);
+    bool getProfiling() const { return profiling; }
+    Profiler &getProfiler() const;
+    /**
+     * @brief NUMA placement: memory from alloc() is bound to the node and
+     * the worker threads of this runtime are kept on its CPUs. -1, the
+     * default, leaves both to the OS. A multi-socket host is used by one
+     * runtime, and one instance of the graph, per node.
+     */
+    void setNumaNode(int node);
+    int getNumaNode() const { return numaNode; }
+    /**
+     * @brief Gives every inter-op and async worker its own slice of the
+     * NUMA node's CPUs (of the whole host without one) and pins the
+     * OpenMP threads running its kernels to the cores of the slice. The
+     * thread calling run() keeps its affinity.
+     */
+    void setThreadPinning(bool enable);
+    bool getThreadPinning() const { return pinThreads; }
+
+  private:
+    Kernel *getKernel(const Operator &op) const;
+    // CPUs threads are pinned to, empty when pinning is off.
+    vector<int> getPinCpus() const;
+    // CPUs of every worker of a pool of n threads.
+    vector<vector<int>> getPoolCpus(int n) const;
+    // Pins the OpenMP team of the calling thread, once per pinning change,
+    // leaving the calling thread itself alone.
+    void pinTeam() const;
+    // Runs op with execute() when params are given, else with compute().
+    void runOp(const Operator &op, Kernel *kernel,
+               const KernelParams *params = nullptr) const;
+    void runParallel(const Graph &graph) const;
+    // Prepares the stale entries of plan on its data.
+    void prepare(ExecutionPlanObj &plan) const;
+
+  public:
     void *alloc(size_t size) override;
     string toString() const override;
   };
@@ -6,6 +6,7 @@
 #include <cmath>
 #include <cstring>
 #include <fstream>
+#include <memory>
 
 namespace infini
 {
@@ -30,8 +31,31 @@ namespace infini
         size_t _size; // Cache of Π(shape).
         Fuid fuid;    // Cloned tensors share the same id. Tensors constructed from
                       // scratch have a new id.
+        Shape strides; // In elements, empty for the dense row-major layout.
+
+        // Data of the innermost DataScope on this thread, if any.
+        inline static thread_local const std::map<const TensorObj *, void *>
+            *scopedData = nullptr;
 
     public:
+        /**
+         * @brief While alive, getRawDataPtr() on the calling thread returns
+         * the pointers in data for the tensors it holds instead of their
+         * blobs. ExecutionPlanObj runs kernels on its own data this way,
+         * leaving the graph's tensors to other threads.
+         */
+        class DataScope
+        {
+            const std::map<const TensorObj *, void *> *outer;
+
+        public:
+            explicit DataScope(const std::map<const TensorObj *, void *> &data)
+                : outer(scopedData) { scopedData = &data; }
+            ~DataScope() { scopedData = outer; }
+            DataScope(const DataScope &) = delete;
+            DataScope &operator=(const DataScope &) = delete;
+        };
+
         TensorObj(Shape shape, DataType dtype, Runtime runtime);
         virtual ~TensorObj() {}
         string toString() const override;
@@ -43,11 +67,25 @@ namespace infini
         void setShape(Shape shape_);
         size_t getRank() const { return shape.size(); }
         UidBaseType getFuid() const { return fuid; }
+        /**
+         * @brief Strides in elements of every dim. Tensors are dense and
+         * row-major, unless GraphObj::dataMalloc() made this one a view
+         * of the data of another, for kernels that support strides (see
+         * Kernel::supportsStrides()).
+         */
+        Shape getStrides() const;
+        bool isContiguous() const;
+        /**
+         * @brief Bytes the data spans through the strides: getBytes() but
+         * for tensors with padded rows (GraphObj::setRowAlignment()).
+         */
+        size_t getStorageBytes() const;
 
         void setData(
             std::function<void(void *, size_t, DataType)> const &generator) const;
 
         void setDataBlob(const Blob &blob);
+        Blob getDataBlob() const { return data; }
 
         void printData() const;
         bool equalData(const Tensor &rhs, double relativeError = 1e-6) const;
@@ -57,7 +95,8 @@ namespace infini
         {
             IT_ASSERT(size() == dataVector.size());
             IT_ASSERT(DataType::get<T>() == dtype.cpuTypeInt());
-            return equalDataImpl(getRawDataPtr<T *>(), dataVector.data(), size());
+            std::unique_ptr<T[]> buffer;
+            return equalDataImpl(denseData(buffer), dataVector.data(), size());
         }
 
         template <typename T>
@@ -65,6 +104,9 @@ namespace infini
         {
             static_assert(std::is_pointer_v<T>,
                           "Raw data pointer has a type of pointer");
+            if (scopedData)
+                if (auto it = scopedData->find(this); it != scopedData->end())
+                    return reinterpret_cast<T>(it->second);
             IT_ASSERT(data != nullptr);
             return data->getPtr<T>();
         }
@@ -76,6 +118,29 @@ namespace infini
         Operator getSource() const { return source.lock(); }
 
     private:
+        /**
+         * @brief The elements in row-major order. A strided tensor has them
+         * gathered through getStrides() into buffer.
+         */
+        template <typename T>
+        const T *denseData(std::unique_ptr<T[]> &buffer) const
+        {
+            auto ptr = getRawDataPtr<T *>();
+            if (isContiguous())
+                return ptr;
+            const auto steps = getStrides();
+            buffer = std::make_unique<T[]>(size());
+            for (size_t i = 0, iEnd = size(); i < iEnd; ++i)
+            {
+                size_t offset = 0;
+                for (size_t d = shape.size(), rest = i; d-- > 0;
+                     rest /= shape[d])
+                    offset += rest % shape[d] * steps[d];
+                buffer[i] = ptr[offset];
+            }
+            return buffer.get();
+        }
+
         template <class T>
         string dataToString() const
         {
@@ -84,7 +149,8 @@ namespace infini
 
             auto numDims = shape.size();
             auto dimSzVec = vector<int>(numDims, 1);
-            auto ptr = data->getPtr<T *>();
+            std::unique_ptr<T[]> buffer;
+            auto ptr = denseData(buffer);
             dimSzVec[numDims - 1] = shape[numDims - 1];
 
             for (int i = numDims - 1; i != 0; --i)
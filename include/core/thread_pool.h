@@ -0,0 +1,58 @@
+#pragma once
+#include "core/common.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace infini
+{
+
+    /**
+     * @brief A fixed-size work-stealing thread pool. Every worker owns a
+     * deque: tasks submitted from a worker go to the back of its own deque
+     * and are taken LIFO for locality, tasks submitted from outside are
+     * spread round-robin, and an idle worker steals from the front of the
+     * other deques.
+     */
+    class ThreadPool
+    {
+        struct Queue
+        {
+            std::mutex mutex;
+            std::deque<std::function<void()>> tasks;
+        };
+
+        vector<std::unique_ptr<Queue>> queues;
+        vector<std::thread> workers;
+        std::mutex sleepMutex;
+        std::condition_variable wakeUp;
+        std::atomic<size_t> queued{0}, nextQueue{0};
+        bool stopping = false;
+
+    public:
+        /**
+         * @brief With cpus given, worker i is pinned to
+         * cpus[i % cpus.size()].
+         */
+        explicit ThreadPool(int nThreads, vector<vector<int>> cpus = {});
+        ~ThreadPool();
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        int size() const { return workers.size(); }
+        void submit(std::function<void()> task);
+        /**
+         * @brief CPUs the calling worker is pinned to, empty on threads
+         * of no pool and on unpinned workers.
+         */
+        static const vector<int> &getWorkerCpus();
+
+    private:
+        bool tryRunOne(size_t self);
+        void workerLoop(size_t self);
+    };
+
+} // namespace infini
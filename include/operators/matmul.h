@@ -47,6 +47,11 @@ namespace infini
 
         int numInputs() const override { return inputs.size(); }
         int numOutputs() const override { return 1; }
+        // A multiply and an add per element of A x B.
+        size_t getFlops() const override
+        {
+            return 2 * outputs[0]->size() * k;
+        }
 
         bool getTransA() const { return transA; }
         bool getTransB() const { return transB; }
@@ -24,6 +24,7 @@ namespace infini
     std::string toString() const override;
     int numInputs() const override { return 1; }
     int numOutputs() const override { return 1; }
+    size_t getFlops() const override { return outputs[0]->size(); }
   };
 
   class ClipObj : public OperatorObj
@@ -39,6 +40,7 @@ namespace infini
     std::optional<float> getMax() const { return maxValue; };
     int numInputs() const override { return 1; }
     int numOutputs() const override { return 1; }
+    size_t getFlops() const override { return outputs[0]->size(); }
 
   private:
     std::optional<float> minValue, maxValue;
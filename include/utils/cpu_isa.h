@@ -0,0 +1,35 @@
+#pragma once
+#ifndef CPU_ISA_H
+#define CPU_ISA_H
+
+#include <string>
+
+namespace infini {
+
+// SIMD instruction set levels the CPU kernels are compiled for, ordered from
+// the narrowest to the widest.
+enum class CpuIsa {
+    Scalar = 0,
+    SSE,    // SSE4.1, 128-bit
+    AVX2,   // AVX2 + FMA, 256-bit
+    AVX512, // AVX-512 F/BW/DQ/VL, 512-bit
+};
+
+// The widest ISA usable by the kernels. It is detected once via cpuid on the
+// first call and can be lowered by set_cpu_isa.
+CpuIsa get_cpu_isa();
+// Cap the ISA used by the kernels, e.g. to compare variants in tests or
+// benchmarks. Requests above what the CPU supports are clamped.
+void set_cpu_isa(CpuIsa isa);
+// The ISA the CPU actually supports, regardless of set_cpu_isa.
+CpuIsa detect_cpu_isa();
+std::string cpu_isa_str(CpuIsa isa);
+
+// Extensions beyond the ISA levels. They are only reported when the level
+// they are used with is enabled, so set_cpu_isa disables them as well.
+bool cpu_has_f16c();        // half <-> float, used with AVX2 and above
+bool cpu_has_avx512_bf16(); // float -> bfloat16, used with AVX512
+
+} // namespace infini
+
+#endif
@@ -0,0 +1,90 @@
+#pragma once
+#ifndef FP16_H
+#define FP16_H
+
+#include <cstdint>
+#include <cstring>
+
+namespace infini {
+
+// Scalar IEEE half and bfloat16 conversions. They are bit-exact with the
+// F16C (VCVTPS2PH/VCVTPH2PS with round-to-nearest-even) and AVX512-BF16
+// (VCVTNEPS2BF16) instructions, so vectorized kernels can use them for
+// their tails and as fallbacks.
+
+inline uint32_t float_as_bits(float f) {
+    uint32_t u;
+    std::memcpy(&u, &f, sizeof(u));
+    return u;
+}
+
+inline float bits_as_float(uint32_t u) {
+    float f;
+    std::memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+inline float fp16_to_float(uint16_t h) {
+    uint32_t sign = uint32_t(h & 0x8000) << 16;
+    uint32_t exp = (h >> 10) & 0x1f, mant = h & 0x3ff;
+    if (exp == 0x1f) // inf/nan, nan is quieted
+        return bits_as_float(sign | 0x7f800000 | (mant << 13) |
+                             (mant ? 0x400000 : 0));
+    if (exp == 0) {
+        if (mant == 0)
+            return bits_as_float(sign);
+        // subnormal: normalize
+        exp = 1;
+        while (!(mant & 0x400)) {
+            mant <<= 1;
+            --exp;
+        }
+        mant &= 0x3ff;
+    }
+    return bits_as_float(sign | ((exp + 112) << 23) | (mant << 13));
+}
+
+inline uint16_t float_to_fp16(float f) {
+    uint32_t u = float_as_bits(f);
+    uint16_t sign = (u >> 16) & 0x8000;
+    uint32_t exp = (u >> 23) & 0xff, mant = u & 0x7fffff;
+    if (exp == 0xff) // inf/nan, nan is quieted and truncated
+        return sign | 0x7c00 | (mant ? 0x200 | (mant >> 13) : 0);
+    int e = int(exp) - 127 + 15;
+    if (e >= 0x1f)
+        return sign | 0x7c00;
+    if (e <= 0) {
+        if (e < -10)
+            return sign;
+        // subnormal half: shift in the implicit bit, round to nearest even
+        mant |= 0x800000;
+        int shift = 14 - e;
+        uint32_t half = mant >> shift, rem = mant & ((1u << shift) - 1);
+        uint32_t mid = 1u << (shift - 1);
+        if (rem > mid || (rem == mid && (half & 1)))
+            ++half;
+        return sign | half;
+    }
+    uint32_t half = (uint32_t(e) << 10) | (mant >> 13), rem = mant & 0x1fff;
+    // a carry out of the mantissa correctly bumps the exponent (up to inf)
+    if (rem > 0x1000 || (rem == 0x1000 && (half & 1)))
+        ++half;
+    return sign | half;
+}
+
+inline float bf16_to_float(uint16_t b) { return bits_as_float(uint32_t(b) << 16); }
+
+// Round to nearest even. Like VCVTNEPS2BF16, subnormal inputs are flushed
+// to a signed zero and nans are quieted.
+inline uint16_t float_to_bf16(float f) {
+    uint32_t u = float_as_bits(f);
+    if ((u & 0x7f800000) == 0)
+        return (u >> 16) & 0x8000;
+    if ((u & 0x7fffffff) > 0x7f800000)
+        return (u >> 16) | 0x40;
+    return (u + 0x7fff + ((u >> 16) & 1)) >> 16;
+}
+
+} // namespace infini
+
+#endif
@@ -21,6 +21,63 @@ size_t delocate_index(const Shape &shapeIndex, const Shape &shape,
 // Convert KernelAttrs to a string representation
 std::string get_kernel_attrs_str(const KernelAttrs &kernelAttrs);
 
+/**
+ * @brief Walks the elements of a broadcast output as runs of contiguous
+ * output elements, keeping the matching offset of every input.
+ *
+ * Size-1 output dims are dropped and adjacent dims that are contiguous for
+ * the output and all inputs are merged, so same-shape inputs collapse into a
+ * single run and row/column/scalar broadcasts into one stride-0 or stride-1
+ * inner loop. Broadcast axes get stride 0.
+ */
+class BroadcastIterator {
+    Shape dims;                      // coalesced output dims, never empty
+    vector<vector<size_t>> strides;  // per input, parallel to dims
+
+  public:
+    BroadcastIterator(const Shape &output, const vector<Shape> &inputs);
+
+    // Number of elements in each run.
+    size_t runSize() const { return dims.back(); }
+    // Number of runs covering the whole output.
+    size_t numRuns() const;
+    // Element stride of input i inside a run, 0 when it is broadcast.
+    size_t runStride(size_t i) const { return strides[i].back(); }
+    const Shape &getDims() const { return dims; }
+
+    /**
+     * @brief Call f(outOffset, inOffsets) for the runs [first, last), where
+     * inOffsets[i] is the element offset of input i at the start of the run.
+     */
+    template <typename F> void forEachRun(size_t first, size_t last, F &&f) const {
+        if (first >= last)
+            return;
+        const size_t outer = dims.size() - 1, nIn = strides.size();
+        vector<size_t> idx(outer), offsets(nIn, 0);
+        for (size_t d = outer, rest = first; d-- > 0;) {
+            idx[d] = rest % dims[d];
+            rest /= dims[d];
+            for (size_t i = 0; i < nIn; ++i)
+                offsets[i] += idx[d] * strides[i][d];
+        }
+        for (size_t run = first; run < last; ++run) {
+            f(run * runSize(), static_cast<const size_t *>(offsets.data()));
+            for (size_t d = outer; d-- > 0;) {
+                for (size_t i = 0; i < nIn; ++i)
+                    offsets[i] += strides[i][d];
+                if (++idx[d] < (size_t)dims[d])
+                    break;
+                for (size_t i = 0; i < nIn; ++i)
+                    offsets[i] -= strides[i][d] * dims[d];
+                idx[d] = 0;
+            }
+        }
+    }
+    template <typename F> void forEachRun(F &&f) const {
+        forEachRun(0, numRuns(), std::forward<F>(f));
+    }
+};
+
 } // namespace infini
 
 #endif
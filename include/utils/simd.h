@@ -0,0 +1,71 @@
+#pragma once
+#ifndef SIMD_H
+#define SIMD_H
+
+#include "utils/cpu_isa.h"
+#include <cstddef>
+#include <cstring>
+
+namespace infini {
+
+// Function attributes that let a single binary carry code for several ISAs.
+// A function marked with one of them must only be called after checking
+// get_cpu_isa().
+#if defined(__x86_64__) || defined(__i386__)
+#define IT_TARGET_SSE __attribute__((target("sse4.1")))
+#define IT_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define IT_TARGET_AVX512                                                       \
+    __attribute__((target("avx512f,avx512bw,avx512dq,avx512vl")))
+// Optional extensions, see cpu_has_f16c() and cpu_has_avx512_bf16().
+#define IT_TARGET_AVX2_F16C __attribute__((target("avx2,fma,f16c")))
+#define IT_TARGET_AVX512_BF16                                                  \
+    __attribute__((target("avx512f,avx512bw,avx512dq,avx512vl,avx512bf16")))
+#else
+#define IT_TARGET_SSE
+#define IT_TARGET_AVX2
+#define IT_TARGET_AVX512
+#define IT_TARGET_AVX2_F16C
+#define IT_TARGET_AVX512_BF16
+#endif
+
+// Helpers working on SIMD vectors are always inlined into the ISA-specific
+// caller, so they are compiled for its target and vectors never cross a
+// function call boundary. For the same reason they take and return vectors
+// by reference only.
+#define IT_SIMD_INLINE inline __attribute__((always_inline))
+
+// Register width in bytes for each ISA.
+template <CpuIsa isa> struct SimdWidth {};
+template <> struct SimdWidth<CpuIsa::SSE> {
+    static constexpr size_t bytes = 16;
+};
+template <> struct SimdWidth<CpuIsa::AVX2> {
+    static constexpr size_t bytes = 32;
+};
+template <> struct SimdWidth<CpuIsa::AVX512> {
+    static constexpr size_t bytes = 64;
+};
+
+// A GCC/Clang generic vector of T filling `Bytes`; arithmetic, comparison
+// and ?: operators map to the native instructions of the caller's target.
+template <typename T, size_t Bytes> struct SimdVec {
+    typedef T type __attribute__((vector_size(Bytes)));
+    static constexpr size_t lanes = Bytes / sizeof(T);
+};
+
+template <typename V, typename T> IT_SIMD_INLINE void simd_load(V &v, const T *p) {
+    std::memcpy(&v, p, sizeof(V));
+}
+
+template <typename V, typename T> IT_SIMD_INLINE void simd_store(T *p, const V &v) {
+    std::memcpy(p, &v, sizeof(V));
+}
+
+template <typename V, typename T> IT_SIMD_INLINE void simd_broadcast(V &v, T x) {
+    for (size_t i = 0; i < sizeof(V) / sizeof(T); ++i)
+        v[i] = x;
+}
+
+} // namespace infini
+
+#endif
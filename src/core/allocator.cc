@@ -1,4 +1,6 @@
 #include "core/allocator.h"
+#include <algorithm>
+#include <iterator>
 #include <utility>
 
 namespace infini
@@ -7,53 +9,65 @@ namespace infini
     {
         used = 0;
         peak = 0;
+        top = 0;
         ptr = nullptr;
+        block = nullptr;
 
-        // 'alignment' defaults to sizeof(uint64_t), because it is the length of
-        // the longest data type currently supported by the DataType field of
-        // the tensor
-        alignment = sizeof(uint64_t);
+        // 'alignment' defaults to a cache line, so that SIMD loads of a tensor
+        // do not straddle lines and tensors written by different threads do
+        // not share one
+        alignment = 64;
+        baseAlignment = alignment;
     }
 
     Allocator::~Allocator()
     {
-        if (this->ptr != nullptr)
+        if (this->block != nullptr)
         {
-            runtime->dealloc(this->ptr);
+            runtime->dealloc(this->block);
         }
     }
 
+    void Allocator::setAlignment(size_t bytes)
+    {
+        IT_ASSERT(bytes > 0 && (bytes & (bytes - 1)) == 0);
+        IT_ASSERT(this->ptr == nullptr && top == 0,
+                  "Alignment is set before allocating");
+        alignment = bytes;
+        baseAlignment = std::max(baseAlignment, bytes);
+    }
+
+    void Allocator::alignBase(size_t bytes)
+    {
+        IT_ASSERT(bytes > 0 && (bytes & (bytes - 1)) == 0);
+        IT_ASSERT(this->ptr == nullptr);
+        baseAlignment = std::max(baseAlignment, bytes);
+    }
+
     size_t Allocator::alloc(size_t size)
     {
         IT_ASSERT(this->ptr == nullptr);
         // pad the size to the multiple of alignment
         size = this->getAlignedSize(size);
+        used += size;
 
-        // =================================== 作业 ===================================
-        // TODO: 设计一个算法来分配内存，返回起始地址偏移量
-        // =================================== 作业 ===================================
-        if (listAllocBlocks.empty()) {
-            listAllocBlocks.insert({0, size});
-            peak = size;
-            used += size;
-
-            return 0;
-        }
-
-        auto found = listFreeBlocks.lower_bound(size);
-        if (found != listFreeBlocks.end()) {
-            auto [ offset, blocksize ] = *found;
-            listFreeBlocks.erase(found);
-            listAllocBlocks.insert({offset, blocksize});
-            used += size;
+        // best fit: the smallest free block that holds the request, with the
+        // rest split off as a new free block
+        auto found = freeBySize.lower_bound({size, 0});
+        if (found != freeBySize.end())
+        {
+            auto [blocksize, offset] = *found;
+            eraseFreeBlock(listFreeBlocks.find(offset));
+            if (blocksize > size)
+                insertFreeBlock(offset + size, blocksize - size);
+            listAllocBlocks.insert({offset, size});
             return offset;
         }
 
-        auto offset = peak;
+        auto offset = top;
         listAllocBlocks.insert({offset, size});
-        peak += size;
-        used += size;
-
+        top += size;
+        peak = std::max(peak, top);
         return offset;
     }
 
@@ -61,31 +75,59 @@ namespace infini
     {
         IT_ASSERT(this->ptr == nullptr);
         size = getAlignedSize(size);
-
-        // =================================== 作业 ===================================
-        // TODO: 设计一个算法来回收内存
-        // =================================== 作业 ===================================
         auto found = listAllocBlocks.find(addr);
-        if (found == listAllocBlocks.end()) {
-            return;
-        }
-
-        IT_ASSERT(found->second == size);
-        auto blocksize = found->second;
+        IT_ASSERT(found != listAllocBlocks.end() && found->second == size,
+                  "Freeing a block that was not allocated");
         listAllocBlocks.erase(found);
-        if (addr + blocksize == peak) {
-            peak -= blocksize;
-        } else {
-            listFreeBlocks.insert({ blocksize, addr });
+        used -= size;
+
+        // coalesce with the free neighbors on both sides
+        auto next = listFreeBlocks.lower_bound(addr);
+        if (next != listFreeBlocks.begin())
+        {
+            auto prev = std::prev(next);
+            if (prev->first + prev->second == addr)
+            {
+                addr = prev->first;
+                size += prev->second;
+                eraseFreeBlock(prev);
+            }
         }
-        used -= blocksize;
+        if (next != listFreeBlocks.end() && addr + size == next->first)
+        {
+            size += next->second;
+            eraseFreeBlock(next);
+        }
+
+        // a free block at the end gives its space back to the tail
+        if (addr + size == top)
+            top = addr;
+        else
+            insertFreeBlock(addr, size);
+    }
+
+    void Allocator::insertFreeBlock(size_t addr, size_t size)
+    {
+        listFreeBlocks.insert({addr, size});
+        freeBySize.insert({size, addr});
+    }
+
+    void Allocator::eraseFreeBlock(map<size_t, size_t>::iterator it)
+    {
+        freeBySize.erase({it->second, it->first});
+        listFreeBlocks.erase(it);
     }
 
     void *Allocator::getPtr()
     {
         if (this->ptr == nullptr)
         {
-            this->ptr = runtime->alloc(this->peak);
+            // the runtime may align less, so the start is aligned within a
+            // slightly larger block
+            this->block = runtime->alloc(this->peak + baseAlignment - 1);
+            auto addr = reinterpret_cast<uintptr_t>(this->block);
+            this->ptr = reinterpret_cast<void *>(
+                (addr + baseAlignment - 1) / baseAlignment * baseAlignment);
             printf("Allocator really alloc: %p %lu bytes\n", this->ptr, peak);
         }
         return this->ptr;
@@ -98,7 +140,20 @@ namespace infini
 
     void Allocator::info()
     {
+        size_t freeBytes = 0, largest = 0;
+        for (auto &[offset, size] : listFreeBlocks)
+        {
+            freeBytes += size;
+            largest = std::max(largest, size);
+        }
+        // the share of free memory not usable by the largest request that
+        // fits below the top
+        double fragmentation = freeBytes ? 1. - (double)largest / freeBytes
+                                         : 0.;
         std::cout << "Used memory: " << this->used
-                  << ", peak memory: " << this->peak << std::endl;
+                  << ", peak memory: " << this->peak
+                  << ", free blocks: " << listFreeBlocks.size() << " ("
+                  << freeBytes << " bytes, largest " << largest
+                  << "), fragmentation: " << fragmentation << std::endl;
     }
 }
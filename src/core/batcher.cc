@@ -0,0 +1,178 @@
+#include "core/batcher.h"
+#include <cstring>
+
+namespace infini
+{
+    DynamicBatcher::DynamicBatcher(Graph graph, TensorVec batchedInputs,
+                                   int maxBatch, Duration maxWait)
+        : graph(std::move(graph)), batchedInputs(std::move(batchedInputs)),
+          maxBatch(maxBatch), maxWait(maxWait)
+    {
+        IT_ASSERT(maxBatch >= 1);
+        IT_ASSERT(as<NativeCpuRuntimeObj>(this->graph->getRuntime()),
+                  "Batching needs a NativeCpuRuntimeObj");
+        for (auto &t : this->batchedInputs)
+            IT_ASSERT(!t->getSource() && t->getRank() > 0,
+                      "Batched tensors must be graph inputs with a leading "
+                      "dim");
+        outputs = this->graph->getOutputs();
+        worker = std::thread([this] { workerLoop(); });
+    }
+
+    DynamicBatcher::~DynamicBatcher()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wakeUp.notify_all();
+        worker.join();
+    }
+
+    std::future<void> DynamicBatcher::submit(vector<const void *> inputs,
+                                             vector<void *> outputs)
+    {
+        IT_ASSERT(inputs.size() == batchedInputs.size());
+        IT_ASSERT(outputs.size() == this->outputs.size());
+        Request request{std::move(inputs), std::move(outputs), {}};
+        auto future = request.done.get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            IT_ASSERT(!stopping);
+            queue.emplace_back(std::move(request),
+                               std::chrono::steady_clock::now());
+        }
+        wakeUp.notify_all();
+        return future;
+    }
+
+    void DynamicBatcher::setMaxBatch(int n)
+    {
+        IT_ASSERT(n >= 1);
+        std::lock_guard<std::mutex> lock(mutex);
+        maxBatch = n;
+    }
+
+    void DynamicBatcher::setMaxWait(Duration wait)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        maxWait = wait;
+    }
+
+    void DynamicBatcher::workerLoop()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true)
+        {
+            wakeUp.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (queue.empty())
+                return;
+            // Wait for a full batch until the first request's deadline; on
+            // shutdown whatever is queued is served at once.
+            auto deadline = queue.front().second + maxWait;
+            wakeUp.wait_until(lock, deadline, [this]
+                              { return stopping ||
+                                       queue.size() >= (size_t)maxBatch; });
+            vector<Request> requests;
+            while (!queue.empty() && requests.size() < (size_t)maxBatch)
+            {
+                requests.emplace_back(std::move(queue.front().first));
+                queue.pop_front();
+            }
+            lock.unlock();
+            runBatch(requests);
+            lock.lock();
+        }
+    }
+
+    DynamicBatcher::Batched &DynamicBatcher::getBatched(int size)
+    {
+        if (auto it = batches.find(size); it != batches.end())
+            return it->second;
+
+        auto runtime = as<NativeCpuRuntimeObj>(graph->getRuntime());
+        Batched b;
+        b.graph = make_ref<GraphObj>(runtime);
+        b.graph->setMemoryAlignment(graph->getMemoryAlignment());
+        b.graph->setRowAlignment(graph->getRowAlignment());
+        std::map<const TensorObj *, Tensor> map;
+        TensorVec shared;
+        for (auto &t : graph->getInputs())
+        {
+            Shape dims = t->getDims();
+            if (std::find(batchedInputs.begin(), batchedInputs.end(), t) !=
+                batchedInputs.end())
+                dims[0] *= size;
+            else
+                shared.emplace_back(t);
+            map[t.get()] = b.graph->addTensor(dims, t->getDType());
+        }
+        IT_ASSERT(graph->topo_sort() == true);
+        for (auto &op : graph->getOperators())
+        {
+            TensorVec inputs;
+            for (auto &t : op->getInputs())
+                inputs.emplace_back(map.at(t.get()));
+            auto newOp = b.graph->cloneOperator(op, inputs);
+            for (size_t i = 0; i < op->getOutputs().size(); ++i)
+                map[op->getOutput(i).get()] = newOp->getOutput(i);
+        }
+        for (auto &t : batchedInputs)
+            b.inputs.emplace_back(map.at(t.get()));
+        for (auto &t : outputs)
+        {
+            b.outputs.emplace_back(map.at(t.get()));
+            // Requests are split along dim 0, so the batch must only grow
+            // that dim: equal bytes are not enough once an op moves it.
+            Shape dims = t->getDims();
+            dims[0] *= size;
+            IT_ASSERT(b.outputs.back()->getDims() == dims,
+                      "Output " + t->toString() +
+                          " is not batched along its leading dim");
+        }
+        for (auto &t : graph->getTensors())
+            if (size_t bytes = graph->getAlignment(t))
+                b.graph->setAlignment(map.at(t.get()), bytes);
+        // Shared inputs read the data of the original graph, so they take
+        // no memory of their own.
+        for (auto &t : shared)
+            b.graph->setExternal(map.at(t.get()));
+        b.graph->dataMalloc();
+        for (auto &t : shared)
+            b.graph->bindExternal(map.at(t.get()), t->getRawDataPtr<void *>());
+        b.plan = runtime->compile(b.graph);
+        return batches.emplace(size, std::move(b)).first->second;
+    }
+
+    void DynamicBatcher::runBatch(vector<Request> &requests)
+    {
+        try
+        {
+            auto &b = getBatched(requests.size());
+            for (size_t i = 0; i < b.inputs.size(); ++i)
+            {
+                const size_t bytes = batchedInputs[i]->getBytes();
+                auto dst = b.inputs[i]->getRawDataPtr<uint8_t *>();
+                for (size_t r = 0; r < requests.size(); ++r)
+                    std::memcpy(dst + r * bytes, requests[r].inputs[i], bytes);
+            }
+            as<NativeCpuRuntimeObj>(graph->getRuntime())->run(b.plan);
+            for (size_t j = 0; j < b.outputs.size(); ++j)
+            {
+                const size_t bytes = outputs[j]->getBytes();
+                auto src = b.outputs[j]->getRawDataPtr<uint8_t *>();
+                for (size_t r = 0; r < requests.size(); ++r)
+                    std::memcpy(requests[r].outputs[j], src + r * bytes, bytes);
+            }
+        }
+        catch (...)
+        {
+            for (auto &r : requests)
+                r.done.set_exception(std::current_exception());
+            return;
+        }
+        for (auto &r : requests)
+            r.done.set_value();
+    }
+
+} // namespace infini
@@ -4,7 +4,9 @@
 #include <queue>
 #include <functional>
 #include "core/runtime.h"
+#include "core/kernel.h"
 #include "core/optimizer.h"
+#include "operators/transpose.h"
 
 using std::function;
 using std::iterator;
@@ -302,34 +304,327 @@ namespace infini
         //std::cout << __func__ << "() begin: num_tensors=" << tensors.size() << std::endl;
         //std::for_each(tensors.cbegin(), tensors.cend(), [](const auto &t){std::cout << "Tensor: " << t << std::endl;});
 
-        void *primePtr = nullptr;
-        auto iter = tensors.begin();
-        auto end = tensors.end();
-        function<void()> lmda_alloc = [this, &iter, &end, &primePtr, &lmda_alloc]{
-            if (iter == end) {
-                primePtr = allocator.getPtr();
-                //std::cout << __func__ << "() prime_ptr=" << primePtr << std::endl;
-                return;
-            } else {
-                auto curiter = iter++;
-                auto shape = (*curiter)->getDims();
-                auto offset = allocator.alloc((*curiter)->getBytes());            
-                lmda_alloc();
-                (*curiter)->setDataBlob(make_ref<BlobObj>(
-                                        runtime,
-                                        static_cast<uint8_t *>(primePtr) + offset));
-                //std::cout << __func__ << "() " << "shape(";
-                //std::for_each(shape.cbegin(), shape.cend(), [](const auto &d){std::cout << d << ",";});
-                /*std::cout << ") at " << primePtr << " " 
-                                << "+ " << offset
-                                << " = " << (*curiter)->getBytes() << std::endl;
-                                */
+        // A tensor lives from the step of its producer to that of its last
+        // consumer; graph inputs are live from the first step and graph
+        // outputs to the last.
+        unordered_map<const OperatorObj *, size_t> step;
+        for (size_t i = 0; i < ops.size(); ++i)
+            step[ops[i].get()] = i;
+        const size_t last = ops.empty() ? 0 : ops.size() - 1;
+        auto &registry = KernelRegistry::getInstance();
+
+        // A Transpose whose consumers all read strides becomes a view of
+        // its input: the output gets permuted strides and the data of the
+        // input, which lives until the view is last used.
+        auto readsStrides = [&](const Tensor &t)
+        {
+            for (auto &target : t->getTargets())
+            {
+                KernelAttrs attrs{runtime->getDevice(),
+                                  target->getOpType().underlying()};
+                if (!registry.hasKernel(attrs))
+                    return false;
+                const auto &inputs = target->getInputs();
+                for (int k = 0; k < (int)inputs.size(); ++k)
+                    for (auto &record : registry.getKernelItems(attrs))
+                        if (inputs[k] == t &&
+                            !std::get<0>(record)->supportsStrides(target, k))
+                            return false;
             }
+            return !t->getTargets().empty();
         };
+        vector<std::pair<Tensor, Tensor>> views; // view, tensor with its data
+        unordered_map<const TensorObj *, Tensor> viewOf;
+        viewOps.clear();
+        for (auto &t : tensors)
+            t->strides.clear();
+        for (auto &op : ops)
+        {
+            if (op->getOpType() != OpType::Transpose)
+                continue;
+            auto input = op->getInputs(0), output = op->getOutput();
+            if (isExternal(input) || isExternal(output) ||
+                !readsStrides(output))
+                continue;
+            auto strides = input->getStrides();
+            auto perm = as<TransposeObj>(op)->getPermute();
+            output->strides.resize(perm.size());
+            for (size_t i = 0; i < perm.size(); ++i)
+                output->strides[i] = strides[perm[i]];
+            auto it = viewOf.find(input.get());
+            auto base = it != viewOf.end() ? it->second : input;
+            viewOf[output.get()] = base;
+            views.emplace_back(output, base);
+            viewOps.insert(op.get());
+        }
+
+        // With a row alignment, a matrix written and read only through
+        // strides gets its rows padded to it.
+        auto writesStrides = [&](const Operator &op)
+        {
+            KernelAttrs attrs{runtime->getDevice(),
+                              op->getOpType().underlying()};
+            if (!registry.hasKernel(attrs))
+                return false;
+            for (auto &record : registry.getKernelItems(attrs))
+                if (!std::get<0>(record)->supportsOutputStrides(op))
+                    return false;
+            return true;
+        };
+        for (auto &op : ops)
+            for (auto &t : op->getOutputs())
+            {
+                const size_t esize = t->getDType().getSize();
+                const size_t rank = t->getRank();
+                if (!rowAlignment || rank < 2 || rowAlignment % esize ||
+                    isExternal(t) ||
+                    viewOf.count(t.get()) || !writesStrides(op) ||
+                    !readsStrides(t))
+                    continue;
+                const auto dims = t->getDims();
+                const size_t row = (dims[rank - 1] * esize + rowAlignment - 1) /
+                                   rowAlignment * rowAlignment / esize;
+                if (row == (size_t)dims[rank - 1])
+                    continue;
+                t->strides.assign(rank, 1);
+                t->strides[rank - 2] = row;
+                for (size_t d = rank - 2; d-- > 0;)
+                    t->strides[d] = t->strides[d + 1] * dims[d + 1];
+            }
+
+        TensorVec planned;
+        vector<MemoryPlanner::Interval> intervals;
+        for (auto &t : tensors)
+        {
+            if (isExternal(t) || viewOf.count(t.get()))
+                continue;
+            MemoryPlanner::Interval interval{0, last, t->getStorageBytes()};
+            if (auto source = t->getSource())
+            {
+                interval.begin = step.at(source.get());
+                if (!t->getTargets().empty())
+                    interval.end = interval.begin;
+                for (auto &target : t->getTargets())
+                    interval.end = std::max(interval.end,
+                                            step.at(target.get()));
+            }
+            if (auto it = alignments.find(t.get()); it != alignments.end())
+            {
+                interval.alignment = it->second;
+                allocator.alignBase(it->second);
+            }
+            // Padded rows start aligned when the matrix does.
+            if (!t->isContiguous())
+            {
+                interval.alignment = std::max(interval.alignment, rowAlignment);
+                allocator.alignBase(rowAlignment);
+            }
+            planned.emplace_back(t);
+            intervals.emplace_back(interval);
+        }
+        unordered_map<const TensorObj *, int> index;
+        for (size_t i = 0; i < planned.size(); ++i)
+            index[planned[i].get()] = i;
+        for (auto &[view, base] : views)
+        {
+            auto &interval = intervals[index.at(base.get())];
+            for (auto &target : view->getTargets())
+                interval.end = std::max(interval.end, step.at(target.get()));
+        }
 
-        lmda_alloc();
+        // An output is computed in place over an input that dies at its op,
+        // when every candidate kernel of the op supports it. Graph inputs
+        // are kept intact.
+        for (auto &op : ops)
+        {
+            KernelAttrs attrs{runtime->getDevice(),
+                              op->getOpType().underlying()};
+            if (op->numOutputs() != 1 || !index.count(op->getOutput().get()) ||
+                !registry.hasKernel(attrs))
+                continue;
+            auto &output = intervals[index[op->getOutput().get()]];
+            const auto &kernels = registry.getKernelItems(attrs);
+            for (int k = 0; k < (int)op->numInputs(); ++k)
+            {
+                auto input = op->getInputs(k);
+                auto it = index.find(input.get());
+                if (it == index.end() || !input->getSource() ||
+                    intervals[it->second].end != output.begin)
+                    continue;
+                bool inPlace = true;
+                for (auto &record : kernels)
+                    inPlace &= std::get<0>(record)->supportsInPlace(op, k);
+                if (inPlace)
+                {
+                    output.alias = it->second;
+                    break;
+                }
+            }
+        }
+        memoryPlan = MemoryPlanner::plan(intervals, allocator.getAlignment());
+
+        if (memoryPlan.arena > 0)
+            allocator.alloc(memoryPlan.arena);
+        auto primePtr = static_cast<uint8_t *>(allocator.getPtr());
+        for (size_t i = 0; i < planned.size(); ++i)
+            planned[i]->setDataBlob(make_ref<BlobObj>(
+                runtime, primePtr + memoryPlan.offsets[i]));
+        for (auto &[view, base] : views)
+            view->setDataBlob(base->getDataBlob());
+
+        findMemoryDependencies();
 
-        allocator.info();
+        auto name = [](const Operator &op)
+        {
+            return string(op->getOpType().toString()) + "#" +
+                   std::to_string(op->getGuid());
+        };
+        vector<MemoryReport::Allocation> allocations;
+        const size_t alignment = allocator.getAlignment();
+        for (size_t i = 0; i < planned.size(); ++i)
+        {
+            auto source = planned[i]->getSource();
+            allocations.push_back(
+                {planned[i]->getFuid(), memoryPlan.offsets[i],
+                 (intervals[i].size + alignment - 1) / alignment * alignment,
+                 intervals[i].begin, intervals[i].end,
+                 source ? name(source) : ""});
+        }
+        vector<string> names;
+        for (auto &op : ops)
+            names.emplace_back(name(op));
+        memoryReport = MemoryReport(std::move(allocations), std::move(names),
+                                    memoryPlan.arena, memoryPlan.lowerBound);
+    }
+
+    void GraphObj::findMemoryDependencies()
+    {
+        // An op writing memory reused from a dead tensor waits for the
+        // earlier ops using that tensor. Tensors sharing memory are found
+        // by a sweep over their address ranges; a view shares the range of
+        // its base, so its readers count as users of the base.
+        unordered_map<const OperatorObj *, size_t> step;
+        for (size_t i = 0; i < ops.size(); ++i)
+            step[ops[i].get()] = i;
+        struct Range
+        {
+            uintptr_t begin, end;
+            Tensor tensor;
+        };
+        vector<Range> ranges;
+        for (auto &t : tensors)
+            if (t->getDataBlob() && t->getStorageBytes() > 0)
+            {
+                auto begin = t->getDataBlob()->getPtr<uintptr_t>();
+                ranges.push_back({begin, begin + t->getStorageBytes(), t});
+            }
+        std::sort(ranges.begin(), ranges.end(),
+                  [](const Range &a, const Range &b)
+                  { return a.begin < b.begin; });
+
+        memoryDeps.clear();
+        auto addDeps = [&](const Tensor &written, const Tensor &used)
+        {
+            auto writer = written->getSource();
+            if (!writer || isView(writer))
+                return;
+            const size_t at = step.at(writer.get());
+            auto &deps = memoryDeps[writer.get()];
+            OpVec users = used->getTargets();
+            if (auto source = used->getSource())
+                users.emplace_back(source);
+            for (auto &op : users)
+                if (step.at(op.get()) < at &&
+                    std::find(deps.begin(), deps.end(), op) == deps.end())
+                    deps.emplace_back(op);
+        };
+        for (size_t k = 0; k < ranges.size(); ++k)
+            for (size_t l = k + 1;
+                 l < ranges.size() && ranges[l].begin < ranges[k].end; ++l)
+            {
+                addDeps(ranges[k].tensor, ranges[l].tensor);
+                addDeps(ranges[l].tensor, ranges[k].tensor);
+            }
+        for (auto &[op, deps] : memoryDeps)
+            std::sort(deps.begin(), deps.end(),
+                      [&](const Operator &a, const Operator &b)
+                      { return step.at(a.get()) < step.at(b.get()); });
+    }
+
+    const OpVec &GraphObj::getMemoryDependencies(const Operator &op) const
+    {
+        static const OpVec none;
+        auto it = memoryDeps.find(op.get());
+        return it != memoryDeps.end() ? it->second : none;
+    }
+
+    void GraphObj::setAlignment(const Tensor &tensor, size_t bytes)
+    {
+        IT_ASSERT(std::find(tensors.begin(), tensors.end(), tensor) !=
+                  tensors.end());
+        IT_ASSERT(bytes > 0 && (bytes & (bytes - 1)) == 0,
+                  "Alignment must be a power of two");
+        IT_ASSERT(!tensor->getDataBlob(),
+                  "Alignment is set before dataMalloc()");
+        alignments[tensor.get()] = bytes;
+    }
+
+    void GraphObj::setRowAlignment(size_t bytes)
+    {
+        IT_ASSERT((bytes & (bytes - 1)) == 0,
+                  "Row alignment must be a power of two");
+        rowAlignment = bytes;
+    }
+
+    void GraphObj::setExternal(const Tensor &tensor)
+    {
+        IT_ASSERT(std::find(tensors.begin(), tensors.end(), tensor) !=
+                  tensors.end());
+        IT_ASSERT(!tensor->getSource() || tensor->getTargets().empty(),
+                  "Only graph inputs and outputs can be external");
+        IT_ASSERT(!tensor->getDataBlob(),
+                  "External tensors must be set before dataMalloc()");
+        if (!isExternal(tensor))
+            externals.emplace_back(tensor);
+    }
+
+    bool GraphObj::isExternal(const Tensor &tensor) const
+    {
+        return std::find(externals.begin(), externals.end(), tensor) !=
+               externals.end();
+    }
+
+    void GraphObj::checkExternal(const Tensor &tensor, const void *ptr) const
+    {
+        IT_ASSERT(isExternal(tensor), "Tensor is not external");
+        IT_ASSERT(reinterpret_cast<uintptr_t>(ptr) %
+                          tensor->getDType().getSize() ==
+                      0,
+                  "External buffer is misaligned");
+    }
+
+    void GraphObj::bindExternal(const Tensor &tensor, void *ptr)
+    {
+        checkExternal(tensor, ptr);
+        tensor->setDataBlob(make_ref<BlobObj>(runtime, ptr));
+    }
+
+    Operator GraphObj::cloneOperator(const Operator &op,
+                                     const TensorVec &inputs)
+    {
+        // Shape inference may update attributes such as Matmul's m, n, k,
+        // so it runs on a copy.
+        auto copy = op->clone(op->getInputs(), op->getOutputs());
+        auto shapes = copy->inferShape(inputs);
+        IT_ASSERT(shapes.has_value(),
+                  "Shape inference failed for " + op->toString());
+        auto dtypes = copy->inferDataType(inputs);
+        TensorVec outputs;
+        for (size_t i = 0; i < shapes->size(); ++i)
+            outputs.emplace_back(addTensor((*shapes)[i], dtypes[i]));
+        auto newOp = copy->clone(inputs, outputs);
+        addOperatorAndConnect(newOp);
+        return newOp;
     }
 
     Tensor GraphObj::addTensor(Shape dim, DataType dtype)
@@ -0,0 +1,136 @@
+#include "core/kernel_tuner.h"
+#include "core/runtime.h"
+#include <chrono>
+#include <cstring>
+#include <fstream>
+
+namespace infini
+{
+    // Each candidate is run once to warm up, then timed this many times
+    // keeping the fastest run.
+    constexpr int TUNE_REPEATS = 3;
+
+    void KernelTuner::setCacheFile(const string &path)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        cacheFile = path;
+        std::ifstream in(path);
+        string line;
+        // Later lines override earlier ones, so the file can be appended to.
+        while (std::getline(in, line))
+        {
+            auto tab = line.rfind('\t');
+            if (tab != string::npos)
+                decisions[line.substr(0, tab)] = line.substr(tab + 1);
+        }
+    }
+
+    void KernelTuner::clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        decisions.clear();
+    }
+
+    string KernelTuner::getKey(const Operator &op)
+    {
+        std::stringstream ss;
+        ss << op->getOpType().toString();
+        for (auto &t : op->getInputs())
+            ss << " " << t->getDType().toString() << vecToString(t->getDims());
+        ss << " ->";
+        for (auto &t : op->getOutputs())
+            ss << " " << t->getDType().toString() << vecToString(t->getDims());
+        return ss.str();
+    }
+
+    optional<string> KernelTuner::getDecision(const Operator &op) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = decisions.find(getKey(op));
+        if (it == decisions.end())
+            return std::nullopt;
+        return it->second;
+    }
+
+    const KernelRegistry::KernelRecord &
+    KernelTuner::tune(const Operator &op, const RuntimeObj *context) const
+    {
+        using Clock = std::chrono::steady_clock;
+        const auto &candidates = KernelRegistry::getInstance().getKernelItems(
+            KernelAttrs{Device::CPU, op->getOpType().underlying()});
+        // The candidates run on scratch copies of the op's tensors: an op
+        // computed in place would otherwise compound on its own output,
+        // and the graph's data is left as it was.
+        std::map<const TensorObj *, void *> scratch;
+        vector<std::unique_ptr<uint8_t[]>> buffers;
+        TensorVec tensors = op->getInputs();
+        for (auto &t : op->getOutputs())
+            tensors.emplace_back(t);
+        for (auto &t : tensors)
+        {
+            if (scratch.count(t.get()))
+                continue;
+            const size_t bytes = t->getStorageBytes();
+            buffers.emplace_back(new uint8_t[bytes + 63]());
+            auto ptr = reinterpret_cast<uintptr_t>(buffers.back().get());
+            void *data = reinterpret_cast<void *>((ptr + 63) / 64 * 64);
+            if (t->getDataBlob())
+                std::memcpy(data, t->getRawDataPtr<void *>(), bytes);
+            scratch[t.get()] = data;
+        }
+        TensorObj::DataScope scope(scratch);
+        const KernelRegistry::KernelRecord *best = nullptr;
+        auto bestTime = Clock::duration::max();
+        for (auto &record : candidates)
+        {
+            Kernel *kernel = std::get<0>(record);
+            try
+            {
+                kernel->compute(op, context);
+            }
+            catch (const Exception &)
+            {
+                continue;
+            }
+            auto time = Clock::duration::max();
+            for (int i = 0; i < TUNE_REPEATS; ++i)
+            {
+                auto begin = Clock::now();
+                kernel->compute(op, context);
+                time = std::min(time, Clock::now() - begin);
+            }
+            if (!best || time < bestTime)
+                best = &record, bestTime = time;
+        }
+        IT_ASSERT(best != nullptr,
+                  "No kernel candidate supports " + getKey(op));
+        return *best;
+    }
+
+    Kernel *KernelTuner::getKernel(const Operator &op,
+                                   const RuntimeObj *context)
+    {
+        const auto &candidates = KernelRegistry::getInstance().getKernelItems(
+            KernelAttrs{Device::CPU, op->getOpType().underlying()});
+        const string key = getKey(op);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = decisions.find(key);
+            if (it != decisions.end())
+                for (auto &record : candidates)
+                    if (std::get<1>(record) == it->second)
+                        return std::get<0>(record);
+        }
+        // Unknown key or a stale decision naming a kernel that is gone.
+        const auto &record = tune(op, context);
+        std::lock_guard<std::mutex> lock(mutex);
+        decisions[key] = std::get<1>(record);
+        if (!cacheFile.empty())
+        {
+            std::ofstream out(cacheFile, std::ios::app);
+            out << key << "\t" << std::get<1>(record) << "\n";
+        }
+        return std::get<0>(record);
+    }
+
+} // namespace infini
@@ -0,0 +1,245 @@
+#include "core/memory_planner.h"
+#include <algorithm>
+#include <functional>
+#include <numeric>
+
+namespace infini
+{
+    namespace
+    {
+        using Interval = MemoryPlanner::Interval;
+
+        size_t alignUp(size_t size, size_t alignment)
+        {
+            return (size + alignment - 1) / alignment * alignment;
+        }
+
+        bool overlaps(const Interval &a, const Interval &b)
+        {
+            return a.begin <= b.end && b.begin <= a.end;
+        }
+
+        // Total size of the tensors live at every step.
+        vector<size_t> breadths(const vector<Interval> &intervals)
+        {
+            size_t steps = 0;
+            for (auto &t : intervals)
+                steps = std::max(steps, t.end + 1);
+            vector<size_t> breadth(steps + 1);
+            for (auto &t : intervals)
+            {
+                breadth[t.begin] += t.size;
+                breadth[t.end + 1] -= t.size;
+            }
+            std::partial_sum(breadth.begin(), breadth.end(), breadth.begin());
+            breadth.pop_back();
+            return breadth;
+        }
+
+        // Pads the intervals and merges every one computed in place into the
+        // group of the interval it aliases: a group is placed as a single
+        // interval, as large as its largest member.
+        vector<Interval> group(const vector<Interval> &intervals,
+                               size_t alignment, vector<size_t> &groupOf)
+        {
+            const size_t n = intervals.size();
+            vector<Interval> groups;
+            groupOf.assign(n, 0);
+            vector<int> state(n, 0); // unvisited, visiting, done
+            vector<bool> aliased(n, false);
+            std::function<void(size_t)> visit = [&](size_t i)
+            {
+                if (state[i])
+                    return;
+                state[i] = 1;
+                const auto &t = intervals[i];
+                IT_ASSERT(t.begin <= t.end);
+                const size_t size = alignUp(t.size, alignment);
+                const size_t align = std::max(t.alignment, alignment);
+                IT_ASSERT((align & (align - 1)) == 0);
+                const int a = t.alias;
+                IT_ASSERT(a < (int)n);
+                if (a >= 0)
+                    visit(a);
+                if (a >= 0 && state[a] == 2 && !aliased[a] &&
+                    intervals[a].end == t.begin &&
+                    groups[groupOf[a]].end == t.begin)
+                {
+                    auto &g = groups[groupOf[a]];
+                    g.end = t.end;
+                    g.size = std::max(g.size, size);
+                    g.alignment = std::max(g.alignment, align);
+                    aliased[a] = true;
+                    groupOf[i] = groupOf[a];
+                }
+                else
+                {
+                    groupOf[i] = groups.size();
+                    groups.push_back({t.begin, t.end, size, -1, align});
+                }
+                state[i] = 2;
+            };
+            for (size_t i = 0; i < n; ++i)
+                visit(i);
+            return groups;
+        }
+
+        // Places the tensors in the given order, each in the smallest (best
+        // fit) or lowest (first fit) gap between the tensors already placed
+        // that it overlaps in time, or above all of them, at an offset
+        // aligned as the tensor requires.
+        MemoryPlanner::Plan place(const vector<Interval> &intervals,
+                                  const vector<size_t> &order, bool bestFit)
+        {
+            MemoryPlanner::Plan plan;
+            plan.offsets.assign(intervals.size(), 0);
+            vector<size_t> placed;
+            vector<std::pair<size_t, size_t>> busy;
+            for (auto i : order)
+            {
+                const auto &t = intervals[i];
+                busy.clear();
+                for (auto j : placed)
+                    if (overlaps(t, intervals[j]))
+                        busy.emplace_back(plan.offsets[j], intervals[j].size);
+                std::sort(busy.begin(), busy.end());
+                size_t cursor = 0, best = SIZE_MAX, bestGap = SIZE_MAX;
+                for (auto [offset, size] : busy)
+                {
+                    size_t start = alignUp(cursor, t.alignment);
+                    if (offset >= start + t.size && offset - start < bestGap)
+                    {
+                        best = start;
+                        bestGap = offset - start;
+                        if (!bestFit)
+                            break;
+                    }
+                    cursor = std::max(cursor, offset + size);
+                }
+                plan.offsets[i] =
+                    best != SIZE_MAX ? best : alignUp(cursor, t.alignment);
+                plan.arena = std::max(plan.arena, plan.offsets[i] + t.size);
+                placed.emplace_back(i);
+            }
+            return plan;
+        }
+    } // namespace
+
+    MemoryPlanner::Plan MemoryPlanner::plan(const vector<Interval> &intervals,
+                                            size_t alignment)
+    {
+        Plan best;
+        bool first = true;
+        for (auto strategy : {Strategy::GreedyBySize, Strategy::GreedyByBreadth,
+                              Strategy::IntervalColoring})
+        {
+            auto candidate = plan(intervals, alignment, strategy);
+            if (first || candidate.arena < best.arena)
+                best = std::move(candidate);
+            first = false;
+        }
+        return best;
+    }
+
+    MemoryPlanner::Plan MemoryPlanner::plan(const vector<Interval> &intervals,
+                                            size_t alignment,
+                                            Strategy strategy)
+    {
+        IT_ASSERT(alignment > 0 && (alignment & (alignment - 1)) == 0);
+        vector<size_t> groupOf;
+        auto padded = group(intervals, alignment, groupOf);
+
+        vector<size_t> order(padded.size());
+        std::iota(order.begin(), order.end(), 0);
+        auto bySize = [&](size_t a, size_t b)
+        {
+            if (padded[a].size != padded[b].size)
+                return padded[a].size > padded[b].size;
+            return padded[a].begin < padded[b].begin;
+        };
+        Plan result;
+        switch (strategy)
+        {
+        case Strategy::GreedyBySize:
+            std::stable_sort(order.begin(), order.end(), bySize);
+            result = place(padded, order, true);
+            break;
+        case Strategy::GreedyByBreadth:
+        {
+            // Steps from the busiest down, each adding its unplaced
+            // tensors from the largest down.
+            auto breadth = breadths(padded);
+            vector<size_t> steps(breadth.size());
+            std::iota(steps.begin(), steps.end(), 0);
+            std::stable_sort(steps.begin(), steps.end(),
+                             [&](size_t a, size_t b)
+                             { return breadth[a] > breadth[b]; });
+            std::stable_sort(order.begin(), order.end(), bySize);
+            vector<size_t> byBreadth;
+            vector<bool> taken(padded.size());
+            for (auto step : steps)
+                for (auto i : order)
+                    if (!taken[i] && padded[i].begin <= step &&
+                        step <= padded[i].end)
+                    {
+                        taken[i] = true;
+                        byBreadth.emplace_back(i);
+                    }
+            result = place(padded, byBreadth, true);
+            break;
+        }
+        case Strategy::IntervalColoring:
+            std::stable_sort(order.begin(), order.end(),
+                             [&](size_t a, size_t b)
+                             {
+                                 if (padded[a].begin != padded[b].begin)
+                                     return padded[a].begin < padded[b].begin;
+                                 return bySize(a, b);
+                             });
+            result = place(padded, order, false);
+            break;
+        default:
+            IT_TODO_HALT();
+        }
+        vector<size_t> offsets(intervals.size());
+        for (size_t i = 0; i < intervals.size(); ++i)
+            offsets[i] = result.offsets[groupOf[i]];
+        result.offsets = std::move(offsets);
+        result.strategy = strategy;
+        result.lowerBound = lowerBound(intervals, alignment);
+        return result;
+    }
+
+    size_t MemoryPlanner::lowerBound(const vector<Interval> &intervals,
+                                     size_t alignment)
+    {
+        vector<size_t> groupOf;
+        auto breadth = breadths(group(intervals, alignment, groupOf));
+        return breadth.empty() ? 0
+                               : *std::max_element(breadth.begin(),
+                                                   breadth.end());
+    }
+
+    string MemoryPlanner::toString(Strategy strategy)
+    {
+        switch (strategy)
+        {
+        case Strategy::GreedyBySize:
+            return "greedy by size";
+        case Strategy::GreedyByBreadth:
+            return "greedy by breadth";
+        case Strategy::IntervalColoring:
+            return "interval coloring";
+        default:
+            IT_TODO_HALT();
+        }
+    }
+
+    string MemoryPlanner::Plan::toString() const
+    {
+        return "Memory plan (" + MemoryPlanner::toString(strategy) +
+               "): arena " + std::to_string(arena) + " bytes, lower bound " +
+               std::to_string(lowerBound) + " bytes";
+    }
+
+} // namespace infini
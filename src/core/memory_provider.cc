@@ -0,0 +1,157 @@
+#include "core/memory_provider.h"
+#include "core/numa.h"
+#include <cstdlib>
+#include <fstream>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace infini
+{
+    namespace
+    {
+        // madvise(MADV_HUGEPAGE) succeeds even when transparent huge pages
+        // are disabled, so the system setting, read once, decides whether
+        // a block can get them.
+        bool transparentHugePagesEnabled()
+        {
+            static const bool enabled = []
+            {
+                std::ifstream file(
+                    "/sys/kernel/mm/transparent_hugepage/enabled");
+                string setting;
+                std::getline(file, setting);
+                return !setting.empty() &&
+                       setting.find("[never]") == string::npos;
+            }();
+            return enabled;
+        }
+    } // namespace
+
+    void MemoryProvider::setAlignment(size_t bytes)
+    {
+        IT_ASSERT(bytes >= sizeof(void *) && (bytes & (bytes - 1)) == 0,
+                  "Alignment must be a power of two");
+        alignment = bytes;
+    }
+
+    void MemoryProvider::setNode(int node)
+    {
+        IT_ASSERT(node >= -1 && node < NumaTopology::getInstance().numNodes(),
+                  "No such NUMA node");
+        this->node = node;
+    }
+
+    void *MemoryProvider::mapPages(size_t bytes, HugePages &mode)
+    {
+#ifdef __linux__
+        if (mode == HugePages::Explicit)
+        {
+            void *ptr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (ptr != MAP_FAILED)
+                return ptr;
+            // The huge page pool is empty or not configured.
+            mode = HugePages::Transparent;
+        }
+        // Map one boundary more than needed and trim both ends, so that
+        // the block starts on a huge page (or alignment) boundary.
+        const size_t boundary =
+            mode == HugePages::None ? alignment : HUGE_PAGE;
+        const size_t mapped = bytes + boundary;
+        void *raw = mmap(nullptr, mapped, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED)
+            return nullptr;
+        auto begin = reinterpret_cast<uintptr_t>(raw);
+        auto aligned = (begin + boundary - 1) / boundary * boundary;
+        if (aligned > begin)
+            munmap(raw, aligned - begin);
+        if (begin + mapped > aligned + bytes)
+            munmap(reinterpret_cast<void *>(aligned + bytes),
+                   begin + mapped - aligned - bytes);
+        void *ptr = reinterpret_cast<void *>(aligned);
+        if (mode != HugePages::None &&
+            (!transparentHugePagesEnabled() ||
+             madvise(ptr, bytes, MADV_HUGEPAGE) != 0))
+            mode = HugePages::None;
+        return ptr;
+#else
+        return nullptr;
+#endif
+    }
+
+    void *MemoryProvider::alloc(size_t size)
+    {
+        size = std::max<size_t>(size, 1);
+        Block block{0, HugePages::None, -1, size};
+        void *ptr = nullptr;
+        const bool huge = hugePages != HugePages::None && size >= HUGE_PAGE;
+        // Binding to a node needs whole pages of our own.
+        if (huge || node >= 0)
+        {
+            const size_t page = huge ? HUGE_PAGE : 4096;
+            block.mode = huge ? hugePages : HugePages::None;
+            block.bytes = (size + page - 1) / page * page;
+            ptr = mapPages(block.bytes, block.mode);
+            if (ptr && node >= 0 &&
+                NumaTopology::bindMemory(ptr, block.bytes, node))
+                block.node = node;
+        }
+        if (!ptr)
+        {
+            block = {0, HugePages::None, -1, size};
+            ptr = std::aligned_alloc(alignment, (size + alignment - 1) /
+                                                    alignment * alignment);
+        }
+        IT_ASSERT(ptr != nullptr, "Out of memory");
+        std::lock_guard<std::mutex> lock(mutex);
+        blocks.emplace(ptr, block);
+        return ptr;
+    }
+
+    void MemoryProvider::dealloc(void *ptr)
+    {
+        if (!ptr)
+            return;
+        Block block;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = blocks.find(ptr);
+            IT_ASSERT(it != blocks.end(), "Unknown memory block");
+            block = it->second;
+            blocks.erase(it);
+        }
+#ifdef __linux__
+        if (block.bytes)
+            return (void)munmap(ptr, block.bytes);
+#endif
+        std::free(ptr);
+    }
+
+    HugePages MemoryProvider::getPageMode(void *ptr) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = blocks.find(ptr);
+        IT_ASSERT(it != blocks.end(), "Unknown memory block");
+        return it->second.mode;
+    }
+
+    int MemoryProvider::getNode(void *ptr) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = blocks.find(ptr);
+        IT_ASSERT(it != blocks.end(), "Unknown memory block");
+        return it->second.node;
+    }
+
+    std::map<int, size_t> MemoryProvider::getNodeUsage() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::map<int, size_t> usage;
+        for (auto &[ptr, block] : blocks)
+            usage[block.node] += block.size;
+        return usage;
+    }
+
+} // namespace infini
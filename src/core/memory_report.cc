@@ -0,0 +1,229 @@
+#include "core/memory_report.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace infini
+{
+    MemoryReport::MemoryReport(vector<Allocation> allocations,
+                               vector<string> ops, size_t arena,
+                               size_t lowerBound)
+        : allocations(std::move(allocations)), arena(arena),
+          lowerBound(lowerBound)
+    {
+        steps.resize(ops.size());
+        vector<vector<std::pair<size_t, size_t>>> ranges(ops.size());
+        for (auto &a : this->allocations)
+            for (size_t s = a.begin; s <= a.end && s < steps.size(); ++s)
+                ranges[s].emplace_back(a.offset, a.offset + a.size);
+        // Live bytes are those covered: a tensor computed in place shares
+        // its bytes with its input at the step computing it.
+        for (size_t s = 0; s < ops.size(); ++s)
+        {
+            steps[s] = {std::move(ops[s]), 0, 0};
+            std::sort(ranges[s].begin(), ranges[s].end());
+            size_t covered = 0;
+            for (auto [lo, hi] : ranges[s])
+            {
+                steps[s].live += hi - std::min(hi, std::max(lo, covered));
+                covered = std::max(covered, hi);
+            }
+            steps[s].extent = covered;
+        }
+    }
+
+    size_t MemoryReport::getPeakStep() const
+    {
+        size_t peak = 0;
+        for (size_t s = 1; s < steps.size(); ++s)
+            if (steps[s].live > steps[peak].live)
+                peak = s;
+        return peak;
+    }
+
+    vector<MemoryReport::Allocation> MemoryReport::getPeakAllocations() const
+    {
+        const size_t peak = getPeakStep();
+        vector<Allocation> live;
+        for (auto &a : allocations)
+            if (a.begin <= peak && peak <= a.end)
+                live.emplace_back(a);
+        std::stable_sort(live.begin(), live.end(),
+                         [](const Allocation &a, const Allocation &b)
+                         { return a.size > b.size; });
+        return live;
+    }
+
+    double MemoryReport::getFragmentation() const
+    {
+        if (arena == 0 || steps.empty())
+            return 0;
+        return 1. - (double)steps[getPeakStep()].live / arena;
+    }
+
+    string MemoryReport::summary() const
+    {
+        std::ostringstream os;
+        os << "Memory: arena " << arena << " bytes, lower bound " << lowerBound
+           << " bytes, fragmentation " << std::fixed << std::setprecision(3)
+           << getFragmentation();
+        if (steps.empty())
+            return os.str();
+        const size_t peak = getPeakStep();
+        os << "\nPeak " << steps[peak].live << " bytes at step " << peak
+           << " (" << steps[peak].op << "), largest tensors:";
+        auto live = getPeakAllocations();
+        for (size_t i = 0; i < std::min<size_t>(live.size(), 5); ++i)
+            os << "\n  fuid " << live[i].fuid << ": " << live[i].size
+               << " bytes, steps [" << live[i].begin << ", " << live[i].end
+               << "], from "
+               << (live[i].producer.empty() ? "input" : live[i].producer);
+        return os.str();
+    }
+
+    void MemoryReport::dumpJson(std::ostream &os) const
+    {
+        // Formatted apart, so that the caller's stream keeps its flags.
+        std::ostringstream fragmentation;
+        fragmentation << std::fixed << std::setprecision(4)
+                      << getFragmentation();
+        os << "{\"arena\": " << arena << ", \"lower_bound\": " << lowerBound
+           << ", \"fragmentation\": " << fragmentation.str();
+        if (!steps.empty())
+        {
+            const size_t peak = getPeakStep();
+            os << ",\n\"peak\": {\"step\": " << peak << ", \"op\": \""
+               << steps[peak].op << "\", \"live\": " << steps[peak].live
+               << ", \"fuids\": [";
+            auto live = getPeakAllocations();
+            for (size_t i = 0; i < live.size(); ++i)
+                os << (i ? ", " : "") << live[i].fuid;
+            os << "]}";
+        }
+        os << ",\n\"allocations\": [";
+        for (size_t i = 0; i < allocations.size(); ++i)
+        {
+            const auto &a = allocations[i];
+            os << (i ? ",\n" : "\n") << "{\"fuid\": " << a.fuid
+               << ", \"offset\": " << a.offset << ", \"size\": " << a.size
+               << ", \"begin\": " << a.begin << ", \"end\": " << a.end
+               << ", \"producer\": \"" << a.producer << "\"}";
+        }
+        os << "\n],\n\"utilization\": [";
+        for (size_t s = 0; s < steps.size(); ++s)
+            os << (s ? ",\n" : "\n") << "{\"step\": " << s << ", \"op\": \""
+               << steps[s].op << "\", \"live\": " << steps[s].live
+               << ", \"extent\": " << steps[s].extent << "}";
+        os << "\n]}\n";
+    }
+
+    void MemoryReport::dumpCsv(std::ostream &os) const
+    {
+        os << "fuid,offset,size,begin,end,producer\n";
+        for (auto &a : allocations)
+            os << a.fuid << ',' << a.offset << ',' << a.size << ',' << a.begin
+               << ',' << a.end << ',' << a.producer << '\n';
+    }
+
+    void MemoryReport::dumpUtilizationCsv(std::ostream &os) const
+    {
+        os << "step,op,live,extent\n";
+        for (size_t s = 0; s < steps.size(); ++s)
+            os << s << ',' << steps[s].op << ',' << steps[s].live << ','
+               << steps[s].extent << '\n';
+    }
+
+    string MemoryReport::renderAscii(size_t width) const
+    {
+        static const string letters =
+            "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
+        IT_ASSERT(width > 0);
+        std::ostringstream os;
+        const size_t peak = getPeakStep();
+        for (size_t s = 0; s < steps.size(); ++s)
+        {
+            string row(width, '.');
+            for (size_t i = 0; i < allocations.size(); ++i)
+            {
+                const auto &a = allocations[i];
+                if (s < a.begin || a.end < s || arena == 0)
+                    continue;
+                // Every tensor covers at least one column.
+                size_t lo = a.offset * width / arena;
+                size_t hi = (a.offset + a.size) * width / arena;
+                hi = std::min(std::max(hi, lo + 1), width);
+                for (size_t c = lo; c < hi; ++c)
+                    row[c] = letters[i % letters.size()];
+            }
+            os << (s == peak ? '*' : ' ') << std::setw(4) << s << " |" << row
+               << "| " << steps[s].op << '\n';
+        }
+        for (size_t i = 0; i < allocations.size(); ++i)
+            os << letters[i % letters.size()] << ": fuid "
+               << allocations[i].fuid << ", " << allocations[i].size
+               << " bytes at " << allocations[i].offset << '\n';
+        return os.str();
+    }
+
+    void MemoryReport::renderSvg(std::ostream &os) const
+    {
+        const double width = 800, rowHeight = 16, left = 40;
+        const double scale = arena ? width / arena : 0;
+        const size_t peak = getPeakStep();
+        os << "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\""
+           << left + width << "\" height=\"" << rowHeight * steps.size()
+           << "\" font-family=\"monospace\" font-size=\"10\">\n";
+        if (!steps.empty())
+            os << "<rect x=\"0\" y=\"" << peak * rowHeight << "\" width=\""
+               << left + width << "\" height=\"" << rowHeight
+               << "\" fill=\"#fee\"/>\n";
+        for (size_t s = 0; s < steps.size(); ++s)
+            os << "<text x=\"2\" y=\"" << (s + 0.75) * rowHeight << "\">" << s
+               << "</text>\n";
+        for (auto &a : allocations)
+        {
+            // A hue per tensor, spread by the golden angle.
+            const int hue = (a.fuid * 137) % 360;
+            os << "<rect x=\"" << left + a.offset * scale << "\" y=\""
+               << a.begin * rowHeight << "\" width=\"" << a.size * scale
+               << "\" height=\"" << (a.end - a.begin + 1) * rowHeight
+               << "\" fill=\"hsl(" << hue << ",60%,70%)\" stroke=\"#333\""
+               << " stroke-width=\"0.5\"><title>fuid " << a.fuid << ": "
+               << a.size << " bytes at " << a.offset
+               << ", steps " << a.begin << "-" << a.end << ", from "
+               << (a.producer.empty() ? "input" : a.producer)
+               << "</title></rect>\n";
+        }
+        os << "</svg>\n";
+    }
+
+    template <typename F>
+    static void writeFile(const string &path, F &&write)
+    {
+        std::ofstream file(path);
+        IT_ASSERT(file.good(), "Cannot open " + path);
+        write(file);
+    }
+
+    void MemoryReport::dumpJson(const string &path) const
+    {
+        writeFile(path, [&](std::ostream &os) { dumpJson(os); });
+    }
+
+    void MemoryReport::dumpCsv(const string &path) const
+    {
+        writeFile(path, [&](std::ostream &os) { dumpCsv(os); });
+    }
+
+    void MemoryReport::dumpUtilizationCsv(const string &path) const
+    {
+        writeFile(path, [&](std::ostream &os) { dumpUtilizationCsv(os); });
+    }
+
+    void MemoryReport::renderSvg(const string &path) const
+    {
+        writeFile(path, [&](std::ostream &os) { renderSvg(os); });
+    }
+
+} // namespace infini
@@ -0,0 +1,132 @@
+#include "core/numa.h"
+#include <algorithm>
+#include <fstream>
+#include <thread>
+#ifdef __linux__
+#include <cerrno>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace infini
+{
+    // Parses a sysfs cpu list such as "0-3,8,10-11".
+    static vector<int> parseCpuList(const string &list)
+    {
+        vector<int> cpus;
+        std::stringstream ss(list);
+        string range;
+        while (std::getline(ss, range, ','))
+        {
+            if (range.empty() || !isdigit(range[0]))
+                continue;
+            auto dash = range.find('-');
+            int first = std::stoi(range.substr(0, dash));
+            int last = dash == string::npos ? first
+                                            : std::stoi(range.substr(dash + 1));
+            for (int cpu = first; cpu <= last; ++cpu)
+                cpus.emplace_back(cpu);
+        }
+        return cpus;
+    }
+
+    // CPUs the calling thread may run on, empty when unknown. The mask
+    // grows until it covers the kernel's CPU ids.
+    static vector<int> readAffinity()
+    {
+        vector<int> cpus;
+#ifdef __linux__
+        for (int n = CPU_SETSIZE; n <= (1 << 20); n *= 2)
+        {
+            cpu_set_t *set = CPU_ALLOC(n);
+            const size_t size = CPU_ALLOC_SIZE(n);
+            CPU_ZERO_S(size, set);
+            const bool ok = sched_getaffinity(0, size, set) == 0;
+            if (ok)
+                for (int cpu = 0; cpu < n; ++cpu)
+                    if (CPU_ISSET_S(cpu, size, set))
+                        cpus.emplace_back(cpu);
+            CPU_FREE(set);
+            if (ok || errno != EINVAL)
+                break;
+        }
+#endif
+        return cpus;
+    }
+
+    NumaTopology::NumaTopology() : processCpus(readAffinity())
+    {
+        for (int node = 0;; ++node)
+        {
+            std::ifstream file("/sys/devices/system/node/node" +
+                               std::to_string(node) + "/cpulist");
+            if (!file)
+                break;
+            string list;
+            std::getline(file, list);
+            nodeCpus.emplace_back(parseCpuList(list));
+        }
+        if (nodeCpus.empty())
+        {
+            nodeCpus.emplace_back();
+            for (int cpu = 0; cpu < (int)std::thread::hardware_concurrency();
+                 ++cpu)
+                nodeCpus[0].emplace_back(cpu);
+        }
+        if (processCpus.empty())
+            for (auto &cpus : nodeCpus)
+                processCpus.insert(processCpus.end(), cpus.begin(), cpus.end());
+    }
+
+    const NumaTopology &NumaTopology::getInstance()
+    {
+        static NumaTopology instance;
+        return instance;
+    }
+
+    int NumaTopology::getNodeOfCpu(int cpu) const
+    {
+        for (int node = 0; node < numNodes(); ++node)
+            for (int c : nodeCpus[node])
+                if (c == cpu)
+                    return node;
+        return -1;
+    }
+
+    bool NumaTopology::bindMemory(void *ptr, size_t bytes, int node)
+    {
+#if defined(__linux__) && defined(SYS_mbind)
+        constexpr int MPOL_BIND = 2;
+        constexpr size_t bits = 8 * sizeof(unsigned long);
+        vector<unsigned long> mask(node / bits + 1, 0);
+        mask[node / bits] = 1ul << (node % bits);
+        return syscall(SYS_mbind, ptr, bytes, MPOL_BIND, mask.data(),
+                       mask.size() * bits + 1, 0) == 0;
+#else
+        return false;
+#endif
+    }
+
+    bool NumaTopology::pinThread(const vector<int> &cpus)
+    {
+#ifdef __linux__
+        if (cpus.empty())
+            return false;
+        const int n = *std::max_element(cpus.begin(), cpus.end()) + 1;
+        if (*std::min_element(cpus.begin(), cpus.end()) < 0)
+            return false;
+        cpu_set_t *set = CPU_ALLOC(n);
+        const size_t size = CPU_ALLOC_SIZE(n);
+        CPU_ZERO_S(size, set);
+        for (int cpu : cpus)
+            CPU_SET_S(cpu, size, set);
+        const bool ok = sched_setaffinity(0, size, set) == 0;
+        CPU_FREE(set);
+        return ok;
+#else
+        return false;
+#endif
+    }
+
+} // namespace infini
@@ -0,0 +1,23 @@
+#include "core/plan.h"
+
+namespace infini
+{
+    void ExecutionPlanObj::bind(const Tensor &tensor, void *ptr)
+    {
+        graph->checkExternal(tensor, ptr);
+        std::lock_guard<std::mutex> lock(running);
+        auto &slot = data.at(tensor.get());
+        if (slot == ptr)
+            return;
+        slot = ptr;
+        for (auto &entry : entries)
+        {
+            const auto &in = entry.op->getInputs();
+            const auto &out = entry.op->getOutputs();
+            if (std::find(in.begin(), in.end(), tensor) != in.end() ||
+                std::find(out.begin(), out.end(), tensor) != out.end())
+                entry.stale = stale = true;
+        }
+    }
+
+} // namespace infini
@@ -0,0 +1,136 @@
+#include "core/profiler.h"
+#include "core/kernel_tuner.h"
+#include <fstream>
+#include <iomanip>
+
+namespace infini
+{
+    static string jsonEscape(const string &s)
+    {
+        string out;
+        for (char c : s)
+        {
+            if (c == '"' || c == '\\')
+                out += '\\';
+            out += c;
+        }
+        return out;
+    }
+
+    void Profiler::record(const Operator &op, Clock::time_point begin,
+                          Clock::time_point end)
+    {
+        using us = std::chrono::duration<double, std::micro>;
+        Record r;
+        r.name = op->getOpType().toString();
+        r.key = KernelTuner::getKey(op);
+        r.flops = op->getFlops();
+        r.bytesRead = 0;
+        for (auto &t : op->getInputs())
+            r.bytesRead += t->getBytes();
+        r.bytesWritten = 0;
+        for (auto &t : op->getOutputs())
+            r.bytesWritten += t->getBytes();
+        r.duration = us(end - begin).count();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        r.start = us(begin - epoch).count();
+        r.thread = threads.emplace(std::this_thread::get_id(), threads.size())
+                       .first->second;
+        records.emplace_back(std::move(r));
+    }
+
+    void Profiler::clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        records.clear();
+        threads.clear();
+        epoch = Clock::now();
+    }
+
+    vector<Profiler::Record> Profiler::getRecords() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return records;
+    }
+
+    void Profiler::dumpChromeTrace(std::ostream &os) const
+    {
+        auto all = getRecords();
+        // Formatted apart, so that the caller's stream keeps its flags.
+        std::ostringstream trace;
+        trace << std::fixed << std::setprecision(3);
+        trace << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+        for (size_t i = 0; i < all.size(); ++i)
+        {
+            const auto &r = all[i];
+            trace << (i ? ",\n" : "\n") << "{\"name\": \""
+                  << jsonEscape(r.name)
+                  << "\", \"cat\": \"op\", \"ph\": \"X\", \"pid\": 0"
+                  << ", \"tid\": " << r.thread << ", \"ts\": " << r.start
+                  << ", \"dur\": " << r.duration
+                  << ", \"args\": {\"shape\": \"" << jsonEscape(r.key)
+                  << "\", \"flops\": " << r.flops
+                  << ", \"bytes_read\": " << r.bytesRead
+                  << ", \"bytes_written\": " << r.bytesWritten << "}}";
+        }
+        trace << "\n]}\n";
+        os << trace.str();
+    }
+
+    void Profiler::dumpChromeTrace(const string &path) const
+    {
+        std::ofstream file(path);
+        IT_ASSERT(file.good(), "Cannot open " + path);
+        dumpChromeTrace(file);
+    }
+
+    string Profiler::summary() const
+    {
+        struct Row
+        {
+            size_t calls = 0;
+            double time = 0; // us
+            double flops = 0, bytes = 0;
+        };
+        std::map<string, Row> rows;
+        auto all = getRecords();
+        double total = 0;
+        for (auto &r : all)
+        {
+            auto &row = rows[r.key];
+            ++row.calls;
+            row.time += r.duration;
+            row.flops += r.flops;
+            row.bytes += r.bytesRead + r.bytesWritten;
+            total += r.duration;
+        }
+        vector<std::pair<string, Row>> sorted(rows.begin(), rows.end());
+        std::stable_sort(sorted.begin(), sorted.end(),
+                         [](auto &a, auto &b)
+                         { return a.second.time > b.second.time; });
+
+        std::ostringstream os;
+        os << std::fixed << std::setprecision(3);
+        os << std::setw(8) << "calls" << std::setw(12) << "total(ms)"
+           << std::setw(12) << "mean(us)" << std::setw(8) << "%"
+           << std::setw(10) << "GFLOP/s" << std::setw(10) << "GB/s"
+           << "  op\n";
+        for (auto &[key, row] : sorted)
+        {
+            // FLOP per us is MFLOP/s, bytes per us MB/s.
+            double t = std::max(row.time, 1e-9);
+            os << std::setw(8) << row.calls << std::setw(12)
+               << row.time / 1000 << std::setw(12) << row.time / row.calls
+               << std::setw(8) << std::setprecision(1)
+               << 100 * row.time / std::max(total, 1e-9)
+               << std::setprecision(3) << std::setw(10)
+               << row.flops / t / 1000 << std::setw(10)
+               << row.bytes / t / 1000 << "  " << key << "\n";
+        }
+        os << "total " << total / 1000 << " ms in " << all.size()
+           << " ops\n";
+        return os.str();
+    }
+
+} // namespace infini
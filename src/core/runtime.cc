@@ -2,35 +2,424 @@
 #include "core/blob.h"
 #include "core/kernel.h"
 #include "core/graph.h"
-#include "core/kernel.h"
+#include "core/kernel_tuner.h"
+#include "core/numa.h"
+#include "core/plan.h"
+#include "core/profiler.h"
+#include "core/thread_pool.h"
+#include <algorithm>
 #include <chrono>
+#include <cstdlib>
 #include <cstring>
 #include <memory>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 namespace infini
 {
+    // Source of NativeCpuRuntimeObj::pinGeneration, shared by all runtimes.
+    static std::atomic<int> pinGenerations{0};
+
+    Kernel *NativeCpuRuntimeObj::getKernel(const Operator &op) const
+    {
+        if (autotune)
+            return KernelTuner::getInstance().getKernel(op, this);
+        return KernelRegistry::getInstance().getKernel(
+            KernelAttrs{device, op->getOpType().underlying()});
+    }
+
     void NativeCpuRuntimeObj::run(const Graph &graph) const
     {
-        const auto &kernelRegistry = KernelRegistry::getInstance();
+        if (pool && graph->getOperators().size() > 1)
+            return runParallel(graph);
+        for (auto &op : graph->getOperators())
+            if (!graph->isView(op))
+                runOp(op, getKernel(op));
+    }
+
+    void NativeCpuRuntimeObj::runOp(const Operator &op, Kernel *kernel,
+                                    const KernelParams *params) const
+    {
+        if (pinGeneration)
+            pinTeam();
+        auto begin = profiling ? Profiler::Clock::now()
+                               : Profiler::Clock::time_point();
+        if (params)
+            kernel->execute(*params, this);
+        else
+            kernel->compute(op, this);
+        if (profiling)
+            profiler->record(op, begin, Profiler::Clock::now());
+    }
+
+    ExecutionPlan NativeCpuRuntimeObj::compile(const Graph &graph,
+                                               bool ownMemory) const
+    {
+        IT_ASSERT(graph->topo_sort() == true);
+        std::shared_ptr<void> planMemory;
+        std::map<const TensorObj *, void *> data;
+        for (auto &t : graph->getExternals())
+        {
+            auto blob = t->getDataBlob();
+            data[t.get()] = blob ? blob->getPtr<void *>() : nullptr;
+        }
+        // Only the activations, the tensors an op computes, can differ
+        // between requests. Weights and the other graph inputs keep
+        // pointing at the graph's data, which plans only read.
+        TensorVec activations;
+        for (auto &t : graph->getTensors())
+        {
+            if (graph->isExternal(t))
+                continue;
+            auto source = t->getSource();
+            if (ownMemory && source && !graph->isView(source))
+                activations.emplace_back(t);
+            else
+                data[t.get()] = t->getRawDataPtr<void *>();
+        }
+        if (ownMemory)
+        {
+            // Activations overlapping in the graph's arena share memory by
+            // liveness, so each run of overlapping ones is copied as a
+            // segment keeping its layout. Segments are packed one after
+            // another, keeping their address modulo the block alignment.
+            std::sort(activations.begin(), activations.end(),
+                      [](const Tensor &a, const Tensor &b)
+                      {
+                          return a->getRawDataPtr<uint8_t *>() <
+                                 b->getRawDataPtr<uint8_t *>();
+                      });
+            const size_t alignment = memory->getAlignment();
+            vector<size_t> offsets;
+            size_t bytes = 0, segment = 0;
+            uint8_t *segBegin = nullptr, *segEnd = nullptr;
+            for (auto &t : activations)
+            {
+                auto ptr = t->getRawDataPtr<uint8_t *>();
+                if (ptr >= segEnd)
+                {
+                    segment = (bytes + alignment - 1) / alignment * alignment +
+                              reinterpret_cast<uintptr_t>(ptr) % alignment;
+                    segBegin = segEnd = ptr;
+                }
+                segEnd = std::max(segEnd, ptr + t->getStorageBytes());
+                bytes = std::max(bytes, segment + (segEnd - segBegin));
+                offsets.emplace_back(segment + (ptr - segBegin));
+            }
+            auto provider = memory;
+            planMemory.reset(provider->alloc(bytes), [provider](void *ptr)
+                             { provider->dealloc(ptr); });
+            for (size_t i = 0; i < activations.size(); ++i)
+                data[activations[i].get()] =
+                    static_cast<uint8_t *>(planMemory.get()) + offsets[i];
+        }
+        // A view reads the data of its input, wherever the plan has it.
+        for (auto &op : graph->getOperators())
+            if (graph->isView(op))
+                data[op->getOutput().get()] = data.at(op->getInputs(0).get());
 
+        vector<ExecutionPlanObj::Entry> entries;
         for (auto &op : graph->getOperators())
+            if (!graph->isView(op))
+                entries.push_back({op, getKernel(op), nullptr, true});
+        auto plan = make_ref<ExecutionPlanObj>(
+            graph, std::move(entries), std::move(planMemory), std::move(data));
+        prepare(*plan);
+        return plan;
+    }
+
+    void NativeCpuRuntimeObj::prepare(ExecutionPlanObj &plan) const
+    {
+        // The kernels read the plan's data through the scope; the graph's
+        // tensors, which other runs may be using, are left alone.
+        TensorObj::DataScope scope(plan.data);
+        for (auto &entry : plan.entries)
+            if (entry.stale)
+            {
+                entry.params = entry.kernel->prepare(entry.op, this);
+                entry.stale = false;
+            }
+        plan.stale = false;
+    }
+
+    void NativeCpuRuntimeObj::run(const ExecutionPlan &plan) const
+    {
+        std::lock_guard<std::mutex> lock(plan->running);
+        for (auto &t : plan->graph->getExternals())
+            IT_ASSERT(plan->data[t.get()] != nullptr,
+                      "External tensor " + t->toString() + " is not bound");
+        if (plan->stale)
+            prepare(*plan);
+        // Entries without params are computed on the plan's data too.
+        TensorObj::DataScope scope(plan->data);
+        for (auto &entry : plan->getEntries())
+            runOp(entry.op, entry.kernel, entry.params.get());
+    }
+
+    std::future<void>
+    NativeCpuRuntimeObj::runAsync(const ExecutionPlan &plan) const
+    {
+        std::shared_ptr<ThreadPool> threads;
         {
-            auto kernelAttrs = KernelAttrs{device, op->getOpType().underlying()};
-            Kernel *kernel = kernelRegistry.getKernel(kernelAttrs);
-            kernel->compute(op, this);
+            std::lock_guard<std::mutex> lock(asyncMutex);
+            if (!asyncPool)
+                asyncPool =
+                    std::make_shared<ThreadPool>(asyncThreads,
+                                                 getPoolCpus(asyncThreads));
+            threads = asyncPool;
         }
+        auto done = std::make_shared<std::promise<void>>();
+        auto future = done->get_future();
+        threads->submit(
+            [this, plan, done]
+            {
+                try
+                {
+                    run(plan);
+                    done->set_value();
+                }
+                catch (...)
+                {
+                    done->set_exception(std::current_exception());
+                }
+            });
+        return future;
     }
 
-    string NativeCpuRuntimeObj::toString() const { return "CPU Runtime"; }
+    void NativeCpuRuntimeObj::setAsyncThreads(int n)
+    {
+        IT_ASSERT(n >= 1);
+        std::lock_guard<std::mutex> lock(asyncMutex);
+        asyncThreads = n;
+        asyncPool = nullptr;
+    }
+
+    void NativeCpuRuntimeObj::runParallel(const Graph &graph) const
+    {
+        const auto &ops = graph->getOperators();
+        const size_t n = ops.size();
+        std::unordered_map<const OperatorObj *, size_t> index;
+        for (size_t i = 0; i < n; ++i)
+            index[ops[i].get()] = i;
+
+        // Dependency counters over the distinct in-graph predecessors.
+        vector<vector<size_t>> successors(n);
+        auto pending = std::make_unique<std::atomic<size_t>[]>(n);
+        vector<size_t> ready;
+        for (size_t i = 0; i < n; ++i)
+        {
+            std::set<size_t> preds;
+            for (auto &pred : ops[i]->getPredecessors())
+                if (auto it = index.find(pred.get()); it != index.end())
+                    preds.insert(it->second);
+            // dataMalloc reuses the memory of dead tensors, so an op also
+            // waits for the earlier ops using the memory it writes.
+            for (auto &dep : graph->getMemoryDependencies(ops[i]))
+                if (auto it = index.find(dep.get()); it != index.end())
+                    preds.insert(it->second);
+            for (auto p : preds)
+                successors[p].emplace_back(i);
+            pending[i] = preds.size();
+            if (preds.empty())
+                ready.emplace_back(i);
+        }
+        {
+            // Check for cycles, which would never become ready.
+            vector<size_t> count(n), order(ready);
+            for (size_t i = 0; i < n; ++i)
+                count[i] = pending[i];
+            for (size_t k = 0; k < order.size(); ++k)
+                for (auto s : successors[order[k]])
+                    if (--count[s] == 0)
+                        order.emplace_back(s);
+            IT_ASSERT(order.size() == n, "Graph has a cycle");
+        }
 
-    void NativeCpuRuntimeObj::dealloc(void *ptr)
+        std::mutex mutex;
+        std::condition_variable allDone;
+        size_t done = 0;
+        std::exception_ptr error;
+        std::atomic<bool> failed{false};
+        std::function<void(size_t)> launch = [&](size_t i)
+        {
+            pool->submit(
+                [&, i]
+                {
+                    // After a failure the remaining ops are only counted,
+                    // as are views, which compute nothing.
+                    if (!failed && !graph->isView(ops[i]))
+                    {
+                        try
+                        {
+                            runOp(ops[i], getKernel(ops[i]));
+                        }
+                        catch (...)
+                        {
+                            std::lock_guard<std::mutex> lock(mutex);
+                            if (!error)
+                                error = std::current_exception();
+                            failed = true;
+                        }
+                    }
+                    for (auto s : successors[i])
+                        if (--pending[s] == 0)
+                            launch(s);
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (++done == n)
+                        allDone.notify_one();
+                });
+        };
+        for (auto i : ready)
+            launch(i);
+        std::unique_lock<std::mutex> lock(mutex);
+        allDone.wait(lock, [&] { return done == n; });
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+    void NativeCpuRuntimeObj::setNumThreads(int n)
+    {
+        IT_ASSERT(n >= 0);
+        numThreads = n;
+    }
+
+    void NativeCpuRuntimeObj::setGrainSize(size_t bytes)
+    {
+        IT_ASSERT(bytes > 0);
+        grainSize = bytes;
+    }
+
+    int NativeCpuRuntimeObj::getNumThreads() const
+    {
+        if (numThreads > 0)
+            return numThreads;
+#ifdef _OPENMP
+        return omp_get_max_threads();
+#else
+        return 1;
+#endif
+    }
+
+    int NativeCpuRuntimeObj::getTaskThreads(size_t work) const
+    {
+        const size_t budget =
+            std::max(1, getNumThreads() / (interOpThreads * asyncThreads));
+        const size_t tasks = work / grainSize;
+        return (int)std::max<size_t>(1, std::min(tasks, budget));
+    }
+
+    void NativeCpuRuntimeObj::setInterOpThreads(int n)
+    {
+        IT_ASSERT(n >= 1);
+        interOpThreads = n;
+        pool = n > 1 ? std::make_shared<ThreadPool>(n, getPoolCpus(n))
+                     : nullptr;
+    }
+
+    void NativeCpuRuntimeObj::setNumaNode(int node)
+    {
+        memory->setNode(node);
+        numaNode = node;
+        pinGeneration = ++pinGenerations;
+        // Re-create the pools on the new CPUs.
+        setInterOpThreads(interOpThreads);
+        setAsyncThreads(asyncThreads);
+    }
+
+    void NativeCpuRuntimeObj::setThreadPinning(bool enable)
+    {
+        pinThreads = enable;
+        pinGeneration = ++pinGenerations;
+        setInterOpThreads(interOpThreads);
+        setAsyncThreads(asyncThreads);
+    }
+
+    vector<int> NativeCpuRuntimeObj::getPinCpus() const
+    {
+        if (!pinThreads && numaNode < 0)
+            return {};
+        const auto &topology = NumaTopology::getInstance();
+        if (numaNode >= 0)
+            return topology.getCpus(numaNode);
+        return topology.getProcessCpus();
+    }
+
+    vector<vector<int>> NativeCpuRuntimeObj::getPoolCpus(int n) const
+    {
+        auto cpus = getPinCpus();
+        if (cpus.empty())
+            return {};
+        if (!pinThreads)
+            return {cpus};
+        // Disjoint slices, so that the teams of concurrent ops do not
+        // share cores; with fewer CPUs than workers they share one each.
+        vector<vector<int>> slices(n);
+        for (int i = 0; i < n; ++i)
+            if (cpus.size() >= (size_t)n)
+                slices[i].assign(cpus.begin() + cpus.size() * i / n,
+                                 cpus.begin() + cpus.size() * (i + 1) / n);
+            else
+                slices[i] = {cpus[i % cpus.size()]};
+        return slices;
+    }
+
+    void NativeCpuRuntimeObj::pinTeam() const
     {
-        return free(ptr);
+        // The pinning the team was last pinned for. Generations are unique
+        // in the process, so a runtime created at the address of a
+        // destroyed one cannot be taken for it.
+        static thread_local int pinned = 0;
+        const int current = pinGeneration;
+        if (pinned == current)
+            return;
+        pinned = current;
+        // A pool worker's team shares its slice. Without pinning the team
+        // is let free on the node, or gets back the affinity the process
+        // started with.
+        auto cpus = ThreadPool::getWorkerCpus();
+        if (cpus.empty())
+            cpus = getPinCpus();
+        if (cpus.empty())
+            cpus = NumaTopology::getInstance().getProcessCpus();
+        // Thread 0 is the calling thread, whose affinity belongs to the
+        // application or was set by its pool.
+        auto pin = [&](int thread)
+        {
+            if (thread == 0)
+                return;
+            if (pinThreads)
+                NumaTopology::pinThread({cpus[thread % cpus.size()]});
+            else
+                NumaTopology::pinThread(cpus);
+        };
+#ifdef _OPENMP
+#pragma omp parallel num_threads(getNumThreads())
+        pin(omp_get_thread_num());
+#else
+        (void)pin; // kernels run on the calling thread alone
+#endif
+    }
+
+    void NativeCpuRuntimeObj::setProfiling(bool enable)
+    {
+        if (enable && !profiler)
+            profiler = std::make_shared<Profiler>();
+        profiling = enable;
+    }
+
+    Profiler &NativeCpuRuntimeObj::getProfiler() const
+    {
+        IT_ASSERT(profiler, "Profiling was never enabled");
+        return *profiler;
     }
 
+    string NativeCpuRuntimeObj::toString() const { return "CPU Runtime"; }
+
+    void NativeCpuRuntimeObj::dealloc(void *ptr) { memory->dealloc(ptr); }
+
     void *NativeCpuRuntimeObj::alloc(size_t size)
     {
-        return calloc((size + sizeof(uint64_t) - 1) / sizeof(uint64_t),
-                      sizeof(uint64_t));
+        return memory->alloc(size);
     }
 
 } // namespace infini
@@ -21,6 +21,7 @@ namespace infini {
             ss << "nullptr data";
         string ret = "Tensor " + std::to_string(guid) + ", Fuid " +
                      std::to_string(fuid) + ", shape " + vecToString(shape) +
+                     (isContiguous() ? "" : ", strides " + vecToString(strides)) +
                      ", dtype " + dtype.toString() + ", " + runtime->toString() +
                      ", " + ss.str() + "\n";
         vector<UidBaseType> targetGuids;
@@ -36,11 +37,36 @@ namespace infini {
 
 void TensorObj::setShape(Shape shape_) {
     shape = shape_;
+    strides.clear();
     size_t size = std::accumulate(shape.begin(), shape.end(), 1,
                                   [](auto acc, auto x) { return acc * x; });
     _size = size;
 }
 
+static Shape denseStrides(const Shape &shape) {
+    Shape dense(shape.size());
+    for (int i = (int)shape.size() - 1, s = 1; i >= 0; s *= shape[i--])
+        dense[i] = s;
+    return dense;
+}
+
+Shape TensorObj::getStrides() const {
+    return strides.empty() ? denseStrides(shape) : strides;
+}
+
+bool TensorObj::isContiguous() const {
+    return strides.empty() || strides == denseStrides(shape);
+}
+
+size_t TensorObj::getStorageBytes() const {
+    if (strides.empty() || _size == 0)
+        return getBytes();
+    size_t last = 0;
+    for (size_t i = 0; i < shape.size(); ++i)
+        last += (shape[i] - 1) * strides[i];
+    return (last + 1) * dtype.getSize();
+}
+
 void TensorObj::printData() const {
     IT_ASSERT(data != nullptr);
     if (!runtime->isCpu())
@@ -80,10 +106,12 @@ bool TensorObj::equalData(const Tensor &rhs, double relativeError) const {
         return false;
 
 #define TEST_EQUAL(N)                                                          \
-    if (dtype == DataType(N))                                                  \
-        return equalDataImpl(getRawDataPtr<DT<N>::t *>(),                      \
-                             rhs->getRawDataPtr<DT<N>::t *>(), size(),         \
-                             relativeError);
+    if (dtype == DataType(N)) {                                                \
+        std::unique_ptr<DT<N>::t[]> lhsBuffer, rhsBuffer;                      \
+        return equalDataImpl(denseData(lhsBuffer),                             \
+                             rhs->denseData(rhsBuffer), size(),                \
+                             relativeError);                                   \
+    }
 
     TEST_EQUAL(0)           // fmt: new line
     else TEST_EQUAL(1)      //
@@ -108,6 +136,8 @@ bool TensorObj::equalData(const Tensor &rhs, double relativeError) const {
 void TensorObj::setData(
     const std::function<void(void *, size_t, DataType)> &generator) const {
     IT_ASSERT(data != nullptr);
+    // Padded rows or a view's shared data would be overwritten densely.
+    IT_ASSERT(isContiguous(), "Cannot set the data of a strided tensor");
     generator(getRawDataPtr<void *>(), size(), dtype);
 }
 
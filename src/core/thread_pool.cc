@@ -0,0 +1,116 @@
+#include "core/thread_pool.h"
+#include "core/numa.h"
+
+namespace infini
+{
+    // The pool and index of the worker running on this thread, if any.
+    static thread_local const ThreadPool *currentPool = nullptr;
+    static thread_local size_t currentWorker = 0;
+    static thread_local vector<int> workerCpus;
+
+    ThreadPool::ThreadPool(int nThreads, vector<vector<int>> cpus)
+    {
+        IT_ASSERT(nThreads > 0);
+        for (int i = 0; i < nThreads; ++i)
+            queues.emplace_back(std::make_unique<Queue>());
+        for (int i = 0; i < nThreads; ++i)
+        {
+            vector<int> mine = cpus.empty() ? vector<int>{}
+                                            : cpus[i % cpus.size()];
+            workers.emplace_back(
+                [this, i, mine]
+                {
+                    if (!mine.empty() && NumaTopology::pinThread(mine))
+                        workerCpus = mine;
+                    workerLoop(i);
+                });
+        }
+    }
+
+    const vector<int> &ThreadPool::getWorkerCpus() { return workerCpus; }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            stopping = true;
+        }
+        wakeUp.notify_all();
+        // A task may drop the last reference to the pool's owner, which
+        // destroys the pool on that worker: it is left to exit on its own.
+        for (auto &worker : workers)
+            if (worker.get_id() == std::this_thread::get_id())
+            {
+                worker.detach();
+                currentPool = nullptr;
+            }
+            else
+                worker.join();
+    }
+
+    void ThreadPool::submit(std::function<void()> task)
+    {
+        size_t target = currentPool == this
+                            ? currentWorker
+                            : nextQueue.fetch_add(1) % queues.size();
+        {
+            // Counted before it is published, so that the worker popping
+            // it cannot decrement first. Taken so that a worker between its
+            // check and its wait cannot miss the notification.
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            ++queued;
+        }
+        {
+            std::lock_guard<std::mutex> lock(queues[target]->mutex);
+            queues[target]->tasks.emplace_back(std::move(task));
+        }
+        wakeUp.notify_one();
+    }
+
+    bool ThreadPool::tryRunOne(size_t self)
+    {
+        std::function<void()> task;
+        for (size_t i = 0; i < queues.size() && !task; ++i)
+        {
+            Queue &q = *queues[(self + i) % queues.size()];
+            std::lock_guard<std::mutex> lock(q.mutex);
+            if (q.tasks.empty())
+                continue;
+            if (i == 0)
+            {
+                task = std::move(q.tasks.back());
+                q.tasks.pop_back();
+            }
+            else
+            {
+                task = std::move(q.tasks.front());
+                q.tasks.pop_front();
+            }
+        }
+        if (!task)
+            return false;
+        --queued;
+        task();
+        return true;
+    }
+
+    void ThreadPool::workerLoop(size_t self)
+    {
+        currentPool = this;
+        currentWorker = self;
+        while (true)
+        {
+            if (tryRunOne(self))
+            {
+                if (currentPool != this)
+                    return;
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            wakeUp.wait(lock, [this] { return stopping || queued > 0; });
+            if (stopping && queued == 0)
+                return;
+        }
+    }
+
+} // namespace infini
@@ -0,0 +1,304 @@
+#include "operators/unary.h"
+#include "core/kernel.h"
+#include "utils/fp16.h"
+#include "utils/simd.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace infini {
+
+namespace {
+
+// Tags for the 16-bit float formats, both stored as uint16_t.
+struct fp16 {};
+struct bf16 {};
+
+template <typename T> struct Storage { using t = T; };
+template <> struct Storage<fp16> { using t = uint16_t; };
+template <> struct Storage<bf16> { using t = uint16_t; };
+template <typename T> using storage_t = typename Storage<T>::t;
+
+template <typename From, typename To>
+IT_SIMD_INLINE storage_t<To> castScalar(storage_t<From> x) {
+    if constexpr (std::is_same_v<From, fp16>)
+        return fp16_to_float(x);
+    else if constexpr (std::is_same_v<From, bf16>)
+        return bf16_to_float(x);
+    else if constexpr (std::is_same_v<To, fp16>)
+        return float_to_fp16(x);
+    else if constexpr (std::is_same_v<To, bf16>)
+        return float_to_bf16(x);
+    else
+        return static_cast<To>(x);
+}
+
+template <typename From, typename To>
+void castRunScalar(const void *src, void *dst, size_t n) {
+    auto in = static_cast<const storage_t<From> *>(src);
+    auto out = static_cast<storage_t<To> *>(dst);
+    for (size_t i = 0; i < n; ++i)
+        out[i] = castScalar<From, To>(in[i]);
+}
+
+// Vector casts built on generic vectors, so each ISA gets its native
+// conversion instructions. Half precision goes through the F16C/AVX-512
+// paths below instead; bfloat16 is plain integer work and is done here.
+template <typename From, typename To, size_t Bytes>
+IT_SIMD_INLINE void castRunVec(const void *src, void *dst, size_t n) {
+    using SF = storage_t<From>;
+    using ST = storage_t<To>;
+    auto in = static_cast<const SF *>(src);
+    auto out = static_cast<ST *>(dst);
+    size_t i = 0;
+    if constexpr (std::is_same_v<From, bf16>) {
+        constexpr size_t lanes = Bytes / sizeof(uint32_t);
+        using VH = typename SimdVec<uint16_t, lanes * 2>::type;
+        using VU = typename SimdVec<uint32_t, lanes * 4>::type;
+        VH h;
+        VU u;
+        for (; i + lanes <= n; i += lanes) {
+            simd_load(h, in + i);
+            u = __builtin_convertvector(h, VU) << 16;
+            simd_store(out + i, u);
+        }
+    } else if constexpr (std::is_same_v<To, bf16>) {
+        // Same rounding, flushing and nan quieting as float_to_bf16.
+        constexpr size_t lanes = Bytes / sizeof(uint32_t);
+        using VH = typename SimdVec<uint16_t, lanes * 2>::type;
+        using VU = typename SimdVec<uint32_t, lanes * 4>::type;
+        VU u, r;
+        VH h;
+        for (; i + lanes <= n; i += lanes) {
+            simd_load(u, in + i);
+            r = (u + 0x7fff + ((u >> 16) & 1)) >> 16;
+            r = (u & 0x7fffffff) > 0x7f800000 ? (u >> 16) | 0x40 : r;
+            r = (u & 0x7f800000) == 0 ? (u >> 16) & 0x8000 : r;
+            h = __builtin_convertvector(r, VH);
+            simd_store(out + i, h);
+        }
+    } else if constexpr (!std::is_same_v<From, fp16> &&
+                         !std::is_same_v<To, fp16>) {
+        constexpr size_t lanes = Bytes / std::max(sizeof(SF), sizeof(ST));
+        using VF = typename SimdVec<SF, lanes * sizeof(SF)>::type;
+        using VT = typename SimdVec<ST, lanes * sizeof(ST)>::type;
+        VF vf;
+        VT vt;
+        for (; i + lanes <= n; i += lanes) {
+            simd_load(vf, in + i);
+            vt = __builtin_convertvector(vf, VT);
+            simd_store(out + i, vt);
+        }
+    }
+    castRunScalar<From, To>(in + i, out + i, n - i);
+}
+
+#define DEFINE_CAST_RUN(isa, target)                                          \
+    template <typename From, typename To>                                     \
+    target void castRun##isa(const void *src, void *dst, size_t n) {          \
+        castRunVec<From, To, SimdWidth<CpuIsa::isa>::bytes>(src, dst, n);     \
+    }
+
+DEFINE_CAST_RUN(SSE, IT_TARGET_SSE)
+DEFINE_CAST_RUN(AVX2, IT_TARGET_AVX2)
+DEFINE_CAST_RUN(AVX512, IT_TARGET_AVX512)
+#undef DEFINE_CAST_RUN
+
+#if defined(__x86_64__) || defined(__i386__)
+IT_TARGET_AVX2_F16C void castFloatToFp16F16c(const void *src, void *dst,
+                                             size_t n) {
+    auto in = static_cast<const float *>(src);
+    auto out = static_cast<uint16_t *>(dst);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i h =
+            _mm256_cvtps_ph(_mm256_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), h);
+    }
+    castRunScalar<float, fp16>(in + i, out + i, n - i);
+}
+
+IT_TARGET_AVX2_F16C void castFp16ToFloatF16c(const void *src, void *dst,
+                                             size_t n) {
+    auto in = static_cast<const uint16_t *>(src);
+    auto out = static_cast<float *>(dst);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        _mm256_storeu_ps(out + i,
+                         _mm256_cvtph_ps(_mm_loadu_si128(
+                             reinterpret_cast<const __m128i *>(in + i))));
+    castRunScalar<fp16, float>(in + i, out + i, n - i);
+}
+
+// The maskz forms avoid a GCC maybe-uninitialized false positive on the
+// unmasked intrinsics.
+IT_TARGET_AVX512 void castFloatToFp16Avx512(const void *src, void *dst,
+                                            size_t n) {
+    auto in = static_cast<const float *>(src);
+    auto out = static_cast<uint16_t *>(dst);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i *>(out + i),
+            _mm512_maskz_cvtps_ph(
+                0xffff, _mm512_loadu_ps(in + i),
+                _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+    castRunScalar<float, fp16>(in + i, out + i, n - i);
+}
+
+IT_TARGET_AVX512 void castFp16ToFloatAvx512(const void *src, void *dst,
+                                            size_t n) {
+    auto in = static_cast<const uint16_t *>(src);
+    auto out = static_cast<float *>(dst);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i h =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + i));
+        _mm512_storeu_ps(out + i, _mm512_maskz_cvtph_ps(0xffff, h));
+    }
+    castRunScalar<fp16, float>(in + i, out + i, n - i);
+}
+
+IT_TARGET_AVX512_BF16 void castFloatToBf16Avx512(const void *src, void *dst,
+                                                 size_t n) {
+    auto in = static_cast<const float *>(src);
+    auto out = static_cast<uint16_t *>(dst);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256bh h = _mm512_cvtneps_pbh(_mm512_loadu_ps(in + i));
+        std::memcpy(out + i, &h, sizeof(h));
+    }
+    castRunScalar<float, bf16>(in + i, out + i, n - i);
+}
+#endif
+
+using CastFunc = void (*)(const void *src, void *dst, size_t n);
+
+template <typename From, typename To> CastFunc getCastFunc() {
+    const CpuIsa isa = get_cpu_isa();
+#if defined(__x86_64__) || defined(__i386__)
+    if constexpr (std::is_same_v<From, float> && std::is_same_v<To, fp16>) {
+        if (isa >= CpuIsa::AVX512)
+            return castFloatToFp16Avx512;
+        if (cpu_has_f16c())
+            return castFloatToFp16F16c;
+    } else if constexpr (std::is_same_v<From, fp16> &&
+                         std::is_same_v<To, float>) {
+        if (isa >= CpuIsa::AVX512)
+            return castFp16ToFloatAvx512;
+        if (cpu_has_f16c())
+            return castFp16ToFloatF16c;
+    } else if constexpr (std::is_same_v<From, float> &&
+                         std::is_same_v<To, bf16>) {
+        if (cpu_has_avx512_bf16())
+            return castFloatToBf16Avx512;
+    }
+#endif
+    switch (isa) {
+    case CpuIsa::AVX512:
+        return castRunAVX512<From, To>;
+    case CpuIsa::AVX2:
+        return castRunAVX2<From, To>;
+    case CpuIsa::SSE:
+        return castRunSSE<From, To>;
+    default:
+        return castRunScalar<From, To>;
+    }
+}
+
+// Elements per parallel task, large enough to stream whole pages.
+constexpr size_t CAST_BLOCK = 1 << 16;
+
+} // namespace
+
+class SimdCast : public CpuKernelWithParams {
+    struct Params : public KernelParams {
+        const void *in;
+        void *out;
+        size_t n, inSize, outSize;
+        CastFunc cast;
+    };
+
+    template <typename From, typename To>
+    static void doPrepare(const Operator &_op, Params &p) {
+        auto op = as<CastObj>(_op);
+        auto input = op->getInputs(0), output = op->getOutput();
+        IT_ASSERT(input->getDType().getSize() == sizeof(storage_t<From>));
+        IT_ASSERT(output->getDType().getSize() == sizeof(storage_t<To>));
+        p.in = input->getRawDataPtr<void *>();
+        p.out = output->getRawDataPtr<void *>();
+        p.n = output->size();
+        p.inSize = sizeof(storage_t<From>);
+        p.outSize = sizeof(storage_t<To>);
+        p.cast = getCastFunc<From, To>();
+    }
+
+    void execute(const KernelParams &params,
+                 const RuntimeObj *context) const override {
+        auto &p = static_cast<const Params &>(params);
+        auto in = static_cast<const uint8_t *>(p.in);
+        auto out = static_cast<uint8_t *>(p.out);
+        const size_t n = p.n;
+        const long nBlocks = (n + CAST_BLOCK - 1) / CAST_BLOCK;
+        const int nThreads =
+            getNumThreads(context, n * (p.inSize + p.outSize));
+#pragma omp parallel for schedule(static) num_threads(nThreads)             \
+    if (nThreads > 1)
+        for (long b = 0; b < nBlocks; ++b) {
+            size_t begin = b * CAST_BLOCK;
+            p.cast(in + begin * p.inSize, out + begin * p.outSize,
+                   std::min(CAST_BLOCK, n - begin));
+        }
+    }
+
+    std::unique_ptr<KernelParams>
+    prepare(const Operator &_op, const RuntimeObj *context) const override {
+        auto p = std::make_unique<Params>();
+#define CASE(TYPE, FROM, TO)                                                   \
+    case CastType::TYPE:                                                       \
+        doPrepare<FROM, TO>(_op, *p);                                          \
+        break
+
+        switch (as<CastObj>(_op)->getType()) {
+            CASE(Float2Float16, float, fp16);
+            CASE(Float2Int64, float, int64_t);
+            CASE(Float2Int32, float, int32_t);
+            CASE(Float2Int16, float, int16_t);
+            CASE(Float2Int8, float, int8_t);
+            CASE(Float2BFloat16, float, bf16);
+            CASE(Int322Float, int32_t, float);
+            CASE(Int322Int8, int32_t, int8_t);
+            CASE(Int322Int16, int32_t, int16_t);
+            CASE(Int322Int64, int32_t, int64_t);
+            CASE(Int162Float, int16_t, float);
+            CASE(Int162Int32, int16_t, int32_t);
+            CASE(Int82Float, int8_t, float);
+            CASE(Int82Int16, int8_t, int16_t);
+            CASE(Int82Int32, int8_t, int32_t);
+            CASE(Uint82Float, uint8_t, float);
+            CASE(Uint82Int32, uint8_t, int32_t);
+            CASE(Uint82Int64, uint8_t, int64_t);
+            CASE(Int642Int32, int64_t, int32_t);
+            CASE(Int642Uint32, int64_t, uint32_t);
+            CASE(Int642Float, int64_t, float);
+            CASE(Uint322Int64, uint32_t, int64_t);
+            CASE(Float162Float, fp16, float);
+            CASE(BFloat162Float, bf16, float);
+            CASE(Float2Float, float, float);
+        default:
+            IT_TODO_HALT();
+        }
+
+#undef CASE
+        return p;
+    }
+
+    // Only casts between types of one size line up in place.
+    bool supportsInPlace(const Operator &op, int input) const override {
+        return sameLayout(op, input);
+    }
+};
+
+REGISTER_KERNEL(Device::CPU, OpType::Cast, SimdCast, "Cast_CPU");
+
+} // namespace infini
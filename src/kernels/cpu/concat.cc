@@ -1,8 +1,45 @@
 #include "operators/concat.h"
 #include "core/kernel.h"
+#include <cstring>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 namespace infini {
 
+namespace {
+
+// Slabs are split into chunks of at most this size so that a concat with
+// few, huge slabs (e.g. along the sequence axis at batch 1) still spreads
+// over all threads.
+constexpr size_t CHUNK_BYTES = 1 << 20;
+// Concats writing more than this bypass the cache with non-temporal stores:
+// the output is far larger than the cache and would only evict the inputs.
+constexpr size_t STREAM_BYTES = 8 << 20;
+
+void copyStream(uint8_t *dst, const uint8_t *src, size_t bytes) {
+#if defined(__SSE2__)
+    size_t head = (16 - reinterpret_cast<uintptr_t>(dst) % 16) % 16;
+    if (head >= bytes) {
+        std::memcpy(dst, src, bytes);
+        return;
+    }
+    std::memcpy(dst, src, head);
+    dst += head, src += head, bytes -= head;
+    size_t body = bytes / 16 * 16;
+    for (size_t i = 0; i < body; i += 16)
+        _mm_stream_si128(
+            reinterpret_cast<__m128i *>(dst + i),
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i)));
+    std::memcpy(dst + body, src + body, bytes - body);
+    _mm_sfence();
+#else
+    std::memcpy(dst, src, bytes);
+#endif
+}
+
+} // namespace
+
 class NaiveConcat : public CpuKernelWithoutConfig {
     template <typename T>
     void doCompute(const Operator &_op, const RuntimeObj *context) const {
@@ -32,7 +69,8 @@ class NaiveConcat : public CpuKernelWithoutConfig {
             auto inSize = input->size();
             auto inPtr = input->getRawDataPtr<T *>(),
                  outPtr = output->getRawDataPtr<T *>();
-#pragma omp parallel for
+            const int nThreads = getNumThreads(context, input->getBytes());
+#pragma omp parallel for num_threads(nThreads) if (nThreads > 1)
             for (size_t iOffset = 0; iOffset < inSize; ++iOffset) {
                 auto oOffset = iOffset % localBlockOffset + innerOffset +
                                iOffset / localBlockOffset * blockOffset;
@@ -43,22 +81,90 @@ class NaiveConcat : public CpuKernelWithoutConfig {
 
     void compute(const Operator &_op,
                  const RuntimeObj *context) const override {
-#define CASE(N)                                                                \
-    case N:                                                                    \
-        doCompute<DT<N>::t>(_op, context)
+        dispatchDType(AllDTypes{}, _op->getDType(), [&](auto tag) {
+            doCompute<typename decltype(tag)::t>(_op, context);
+        });
+    }
+};
+
+/**
+ * @brief Each input contributes one contiguous slab of
+ * dims[dim] * inner elements per outer index, so the concat is a list of
+ * memcpy's. Works on bytes and thus supports every dtype.
+ */
+class SlabConcat : public CpuKernelWithParams {
+    struct Params : public KernelParams {
+        uint8_t *outPtr;
+        size_t outer, outBlock, total;
+        // Per input: slab bytes, data and byte offset within an output
+        // block. chunkBegin[i] is the first unit of input i within an
+        // outer index.
+        vector<size_t> slabs, dimOffsets, chunkBegin{0};
+        vector<const uint8_t *> inPtrs;
+    };
 
-        int dataTypeIdx = _op->getDType().getIndex();
-        switch (dataTypeIdx) {
-            CASE(1); // DataType::Float32
-            break;
-            CASE(12); // DataType::UInt32
-            break;
-        default:
-            IT_TODO_HALT();
+    std::unique_ptr<KernelParams>
+    prepare(const Operator &_op, const RuntimeObj *context) const override {
+        auto op = as<ConcatObj>(_op);
+        auto output = op->getOutput();
+        const size_t dim = op->getDim();
+        const auto outDim = output->getDims();
+        const size_t esize = output->getDType().getSize();
+        auto p = std::make_unique<Params>();
+
+        size_t outer = 1, inner = esize;
+        for (size_t i = 0; i < dim; ++i)
+            outer *= outDim[i];
+        for (size_t i = dim + 1; i < outDim.size(); ++i)
+            inner *= outDim[i];
+        p->outer = outer;
+        p->outBlock = outDim[dim] * inner;
+
+        // Work units are (outer index, input, chunk of the slab) triples.
+        size_t dimOffset = 0;
+        for (auto &input : op->getInputs()) {
+            const size_t slab = input->getDims()[dim] * inner;
+            p->slabs.emplace_back(slab);
+            p->inPtrs.emplace_back(slab ? input->getRawDataPtr<uint8_t *>()
+                                        : nullptr);
+            p->dimOffsets.emplace_back(dimOffset);
+            p->chunkBegin.emplace_back(p->chunkBegin.back() +
+                                       (slab + CHUNK_BYTES - 1) / CHUNK_BYTES);
+            dimOffset += slab;
+        }
+        p->outPtr = output->getRawDataPtr<uint8_t *>();
+        p->total = output->getBytes();
+        return p;
+    }
+
+    void execute(const KernelParams &params,
+                 const RuntimeObj *context) const override {
+        auto &p = static_cast<const Params &>(params);
+        const auto &slabs = p.slabs, &chunkBegin = p.chunkBegin;
+        const size_t unitsPerOuter = chunkBegin.back();
+        const long nUnits = p.outer * unitsPerOuter;
+        const bool stream = p.total >= STREAM_BYTES;
+        const int nThreads = getNumThreads(context, p.total);
+#pragma omp parallel for schedule(static) num_threads(nThreads)             \
+    if (nThreads > 1)
+        for (long u = 0; u < nUnits; ++u) {
+            size_t o = u / unitsPerOuter, r = u % unitsPerOuter, i = 0;
+            while (r >= chunkBegin[i + 1])
+                ++i;
+            size_t off = (r - chunkBegin[i]) * CHUNK_BYTES;
+            size_t bytes = std::min(CHUNK_BYTES, slabs[i] - off);
+            const uint8_t *src = p.inPtrs[i] + o * slabs[i] + off;
+            uint8_t *dst = p.outPtr + o * p.outBlock + p.dimOffsets[i] + off;
+            if (stream)
+                copyStream(dst, src, bytes);
+            else
+                std::memcpy(dst, src, bytes);
         }
     }
 };
 
-REGISTER_KERNEL(Device::CPU, OpType::Concat, NaiveConcat, "ConcatNaive_CPU");
+REGISTER_KERNEL(Device::CPU, OpType::Concat, SlabConcat, "ConcatSlab_CPU");
+REGISTER_KERNEL(Device::CPU, OpType::Concat, NaiveConcat, "ConcatNaive_CPU",
+                -1);
 
 } // namespace infini
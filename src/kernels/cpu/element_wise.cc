@@ -1,119 +1,350 @@
 #include "operators/element_wise.h"
 #include "core/kernel.h"
+#include "utils/fp16.h"
 #include "utils/operator_utils.h"
+#include "utils/simd.h"
 
 namespace infini
 {
-    class NativeElementWise : public CpuKernelWithoutConfig
+    struct AddCompute
     {
         template <typename T>
-        static T addCompute(T val0, T val1)
+        static IT_SIMD_INLINE void apply(T &out, const T &val0, const T &val1)
         {
-            return val0 + val1;
+            out = val0 + val1;
         }
+    };
 
+    struct SubCompute
+    {
         template <typename T>
-        static T subCompute(T val0, T val1)
+        static IT_SIMD_INLINE void apply(T &out, const T &val0, const T &val1)
         {
-            return val0 - val1;
+            out = val0 - val1;
         }
+    };
 
+    struct MulCompute
+    {
         template <typename T>
-        static T mulCompute(T val0, T val1)
+        static IT_SIMD_INLINE void apply(T &out, const T &val0, const T &val1)
         {
-            return val0 * val1;
+            out = val0 * val1;
         }
+    };
 
+    struct DivCompute
+    {
         template <typename T>
-        static T divCompute(T val0, T val1)
+        static IT_SIMD_INLINE void apply(T &out, const T &val0, const T &val1)
         {
-            return (T)(val0 / val1);
+            out = (T)(val0 / val1);
         }
+    };
 
-        template <typename T>
-        void doCompute(const Operator &_op, const RuntimeObj *context) const
+    // Computes one broadcast run: the inputs advance by 1 or stay put
+    // (stride 0).
+    template <typename T>
+    using RunFunc = void (*)(T *out, const T *in0, const T *in1, size_t n,
+                             size_t stride0, size_t stride1);
+
+    // Every numeric dtype, plus Float16 and BFloat16 computed in float.
+    using ElementWiseDTypes =
+        DTypeList<1, 2, 3, 4, 5, 6, 7, 10, 11, 12, 13, 16>;
+
+    // Elements of a half precision run widened to float at a time.
+    constexpr size_t HALF_CHUNK = 256;
+
+    template <typename Op, typename T>
+    static void scalarRun(T *out, const T *in0, const T *in1, size_t n,
+                          size_t stride0, size_t stride1)
+    {
+        if (stride0 == 1 && stride1 == 1)
+            for (size_t i = 0; i < n; ++i)
+                Op::apply(out[i], in0[i], in1[i]);
+        else if (stride0 == 0)
+            for (size_t i = 0; i < n; ++i)
+                Op::apply(out[i], *in0, in1[i * stride1]);
+        else if (stride1 == 0)
+            for (size_t i = 0; i < n; ++i)
+                Op::apply(out[i], in0[i * stride0], *in1);
+        else
+            for (size_t i = 0; i < n; ++i)
+                Op::apply(out[i], in0[i * stride0], in1[i * stride1]);
+    }
+
+    template <typename Op, typename T, size_t Bytes>
+    static IT_SIMD_INLINE void simdRun(T *out, const T *in0, const T *in1,
+                                       size_t n, size_t stride0,
+                                       size_t stride1)
+    {
+        using V = typename SimdVec<T, Bytes>::type;
+        constexpr size_t lanes = SimdVec<T, Bytes>::lanes;
+        size_t i = 0;
+        V v0, v1, res;
+        if (stride0 == 1 && stride1 == 1)
+            for (; i + lanes <= n; i += lanes)
+            {
+                simd_load(v0, in0 + i);
+                simd_load(v1, in1 + i);
+                Op::apply(res, v0, v1);
+                simd_store(out + i, res);
+            }
+        else if (stride0 == 0 && stride1 == 1)
         {
-            auto op = as<ElementWiseObj>(_op);
-            T *inptr0 = op->getInputs(0)->getRawDataPtr<T *>();
-            T *inptr1 = op->getInputs(1)->getRawDataPtr<T *>();
-            T *outptr = op->getOutput()->getRawDataPtr<T *>();
-
-            auto shapeA = op->getInputs(0)->getDims();
-            auto shapeB = op->getInputs(1)->getDims();
-            auto shapeC = op->getOutput()->getDims();
-            auto rank = op->getOutput()->getRank();
-            Shape a(rank, 1);
-            Shape b(rank, 1);
-            std::copy(shapeA.begin(), shapeA.end(),
-                      a.begin() + (rank - shapeA.size()));
-            std::copy(shapeB.begin(), shapeB.end(),
-                      b.begin() + (rank - shapeB.size()));
-            auto getStride = [&](const Shape &shape)
+            simd_broadcast(v0, *in0);
+            for (; i + lanes <= n; i += lanes)
+            {
+                simd_load(v1, in1 + i);
+                Op::apply(res, v0, v1);
+                simd_store(out + i, res);
+            }
+        }
+        else if (stride0 == 1 && stride1 == 0)
+        {
+            simd_broadcast(v1, *in1);
+            for (; i + lanes <= n; i += lanes)
+            {
+                simd_load(v0, in0 + i);
+                Op::apply(res, v0, v1);
+                simd_store(out + i, res);
+            }
+        }
+        // Scalar tail
+        scalarRun<Op>(out + i, in0 + i * stride0, in1 + i * stride1, n - i,
+                      stride0, stride1);
+    }
+
+#define DEFINE_SIMD_RUN(isa, target)                                          \
+    template <typename Op, typename T>                                        \
+    target void simdRun##isa(T *out, const T *in0, const T *in1, size_t n,    \
+                             size_t stride0, size_t stride1)                  \
+    {                                                                         \
+        simdRun<Op, T, SimdWidth<CpuIsa::isa>::bytes>(out, in0, in1, n,       \
+                                                      stride0, stride1);      \
+    }
+
+    DEFINE_SIMD_RUN(SSE, IT_TARGET_SSE)
+    DEFINE_SIMD_RUN(AVX2, IT_TARGET_AVX2)
+    DEFINE_SIMD_RUN(AVX512, IT_TARGET_AVX512)
+#undef DEFINE_SIMD_RUN
+
+    class NativeElementWise : public CpuKernelWithParams
+    {
+    protected:
+        struct Params : public KernelParams
+        {
+            BroadcastIterator iter;
+            void *out;
+            const void *in0, *in1;
+            size_t bytes;
+            CpuIsa isa;
+            void (*exec)(const Params &params, int nThreads);
+
+            Params(BroadcastIterator iter) : iter(std::move(iter)) {}
+        };
+
+        template <typename Op, typename T>
+        static RunFunc<T> getRunFunc(CpuIsa isa)
+        {
+            switch (isa)
             {
-                int p = 1;
-                Shape stride(rank);
-                for (auto i = rank; i > 0; --i)
+            case CpuIsa::AVX512:
+                return simdRunAVX512<Op, T>;
+            case CpuIsa::AVX2:
+                return simdRunAVX2<Op, T>;
+            case CpuIsa::SSE:
+                return simdRunSSE<Op, T>;
+            default:
+                return scalarRun<Op, T>;
+            }
+        }
+
+        // ISA the runs are computed with; the native kernel stays scalar.
+        virtual CpuIsa getIsa() const { return CpuIsa::Scalar; }
+
+        // Calls f(outOffset, inOffset0, inOffset1, count) over pieces of
+        // runs covering the output, on nThreads threads: whole runs are
+        // shared out when there are enough of them, otherwise every run of
+        // elements of elemSize bytes is cut into one piece per thread.
+        template <typename F>
+        static void forEachPiece(const BroadcastIterator &iter, int nThreads,
+                                 size_t elemSize, F &&f)
+        {
+            const size_t n = iter.runSize(), runs = iter.numRuns();
+            const size_t line = std::max<size_t>(1, 64 / elemSize);
+            const size_t stride0 = iter.runStride(0), stride1 = iter.runStride(1);
+            auto wholeRun = [&](size_t outOffset, const size_t *inOffsets)
+            { f(outOffset, inOffsets[0], inOffsets[1], n); };
+            if (nThreads <= 1)
+                return iter.forEachRun(wholeRun);
+            if (runs >= (size_t)nThreads)
+            {
+#pragma omp parallel for schedule(static) num_threads(nThreads)
+                for (int t = 0; t < nThreads; ++t)
+                    iter.forEachRun(runs * t / nThreads,
+                                    runs * (t + 1) / nThreads, wholeRun);
+                return;
+            }
+            iter.forEachRun(
+                [&](size_t outOffset, const size_t *inOffsets)
                 {
-                    stride[i - 1] = p;
-                    p = p * shape[i - 1];
-                }
-                return stride;
+#pragma omp parallel for schedule(static) num_threads(nThreads)
+                    for (int t = 0; t < nThreads; ++t)
+                    {
+                        // Piece boundaries are kept on 64-byte cache lines.
+                        size_t begin = n * t / nThreads / line * line;
+                        size_t end = t + 1 == nThreads
+                                         ? n
+                                         : n * (t + 1) / nThreads / line * line;
+                        if (begin < end)
+                            f(outOffset + begin,
+                              inOffsets[0] + begin * stride0,
+                              inOffsets[1] + begin * stride1, end - begin);
+                    }
+                });
+        }
+
+        template <typename T, typename Op>
+        static void execRuns(const Params &p, int nThreads)
+        {
+            auto inptr0 = static_cast<const T *>(p.in0);
+            auto inptr1 = static_cast<const T *>(p.in1);
+            auto outptr = static_cast<T *>(p.out);
+            const size_t stride0 = p.iter.runStride(0);
+            const size_t stride1 = p.iter.runStride(1);
+            RunFunc<T> run = getRunFunc<Op, T>(p.isa);
+            forEachPiece(p.iter, nThreads, sizeof(T),
+                         [&](size_t outOffset, size_t inOffset0,
+                             size_t inOffset1, size_t count)
+                         { run(outptr + outOffset, inptr0 + inOffset0,
+                               inptr1 + inOffset1, count, stride0, stride1); });
+        }
+
+        // Float16 and BFloat16 are computed in float: each run is widened
+        // chunk by chunk, computed with the float run function and narrowed
+        // back with round-to-nearest-even.
+        template <typename Tag, typename Op>
+        static void execHalf(const Params &p, int nThreads)
+        {
+            auto inptr0 = static_cast<const uint16_t *>(p.in0);
+            auto inptr1 = static_cast<const uint16_t *>(p.in1);
+            auto outptr = static_cast<uint16_t *>(p.out);
+            const size_t stride0 = p.iter.runStride(0);
+            const size_t stride1 = p.iter.runStride(1);
+            RunFunc<float> run = getRunFunc<Op, float>(p.isa);
+            constexpr bool fp16 = std::is_same_v<Tag, DT<10>>;
+            auto widen = [](float *dst, const uint16_t *src, size_t m,
+                            size_t stride)
+            {
+                for (size_t i = 0; i < m; ++i)
+                    dst[i] = fp16 ? fp16_to_float(src[i * stride])
+                                  : bf16_to_float(src[i * stride]);
             };
-            Shape strideA = getStride(a);
-            Shape strideB = getStride(b);
+            forEachPiece(
+                p.iter, nThreads, sizeof(uint16_t),
+                [&](size_t outOffset, size_t inOffset0, size_t inOffset1,
+                    size_t count)
+                {
+                    float a[HALF_CHUNK], b[HALF_CHUNK], c[HALF_CHUNK];
+                    for (size_t i = 0; i < count; i += HALF_CHUNK)
+                    {
+                        size_t m = std::min(HALF_CHUNK, count - i);
+                        widen(a, inptr0 + inOffset0 + i * stride0,
+                              stride0 ? m : 1, stride0);
+                        widen(b, inptr1 + inOffset1 + i * stride1,
+                              stride1 ? m : 1, stride1);
+                        run(c, a, b, m, stride0 ? 1 : 0, stride1 ? 1 : 0);
+                        uint16_t *out = outptr + outOffset + i;
+                        for (size_t j = 0; j < m; ++j)
+                            out[j] = fp16 ? float_to_fp16(c[j])
+                                          : float_to_bf16(c[j]);
+                    }
+                });
+        }
+
+        template <typename Tag, typename Op>
+        static void exec(const Params &p, int nThreads)
+        {
+            if constexpr (std::is_same_v<Tag, DT<10>> ||
+                          std::is_same_v<Tag, DT<16>>)
+                execHalf<Tag, Op>(p, nThreads);
+            else
+                execRuns<typename Tag::t, Op>(p, nThreads);
+        }
 
-            auto n = op->getOutput()->size();
-            T (*_doCompute)
-            (T val0, T val1);
-            switch (op->getOpType().underlying())
+        template <typename Tag>
+        static auto getExec(OpType type)
+        {
+            switch (type.underlying())
             {
             case OpType::Add:
-                _doCompute = addCompute<T>;
-                break;
+                return exec<Tag, AddCompute>;
             case OpType::Sub:
-                _doCompute = subCompute<T>;
-                break;
+                return exec<Tag, SubCompute>;
             case OpType::Mul:
-                _doCompute = mulCompute<T>;
-                break;
+                return exec<Tag, MulCompute>;
             case OpType::Div:
-                _doCompute = divCompute<T>;
-                break;
+                return exec<Tag, DivCompute>;
             default:
                 IT_TODO_HALT();
             }
+        }
 
-            for (size_t i = 0; i < n; ++i)
-            {
-                auto shapeIndexC = locate_index(i, shapeC);
-                auto indexA = delocate_index(shapeIndexC, a, strideA);
-                auto indexB = delocate_index(shapeIndexC, b, strideB);
-                outptr[i] = _doCompute(inptr0[indexA], inptr1[indexB]);
-            }
+    public:
+        std::unique_ptr<KernelParams>
+        prepare(const Operator &_op, const RuntimeObj *context) const override
+        {
+            auto op = as<ElementWiseObj>(_op);
+            auto p = std::make_unique<Params>(BroadcastIterator(
+                op->getOutput()->getDims(),
+                {op->getInputs(0)->getDims(), op->getInputs(1)->getDims()}));
+            p->out = op->getOutput()->getRawDataPtr<void *>();
+            p->in0 = op->getInputs(0)->getRawDataPtr<void *>();
+            p->in1 = op->getInputs(1)->getRawDataPtr<void *>();
+            p->bytes = op->getOutput()->getBytes();
+            p->isa = getIsa();
+            dispatchDType(ElementWiseDTypes{}, op->getDType(), [&](auto tag)
+                          { p->exec = getExec<decltype(tag)>(op->getOpType()); });
+            return p;
         }
 
-        void compute(const Operator &_op,
+        void execute(const KernelParams &params,
                      const RuntimeObj *context) const override
         {
-#define CASE(N) \
-    case N:     \
-        doCompute<DT<N>::t>(_op, context)
+            auto &p = static_cast<const Params &>(params);
+            p.exec(p, getNumThreads(context, p.bytes));
+        }
 
-            int dataTypeIdx = _op->getDType().getIndex();
-            switch (dataTypeIdx)
-            {
-                CASE(1); // DataType::Float32
-                break;
-                CASE(12); // DataType::UInt32
-                break;
-            default:
-                IT_TODO_HALT();
-            }
+        // The aliased input is not broadcast, so each run reads its
+        // elements at the positions it writes.
+        bool supportsInPlace(const Operator &op, int input) const override
+        {
+            return sameLayout(op, input);
         }
     };
 
-    REGISTER_KERNEL(Device::CPU, OpType::Add, NativeElementWise, "addNaive_CPU");
-    REGISTER_KERNEL(Device::CPU, OpType::Sub, NativeElementWise, "subNaive_CPU");
-    REGISTER_KERNEL(Device::CPU, OpType::Mul, NativeElementWise, "mulNaive_CPU");
-    REGISTER_KERNEL(Device::CPU, OpType::Div, NativeElementWise, "divNaive_CPU");
+    /**
+     * @brief Explicitly vectorized element-wise kernel. The widest of
+     * AVX-512, AVX2 and SSE supported by the CPU is picked through
+     * get_cpu_isa(), with a scalar loop for the tail of each run.
+     */
+    class SimdElementWise : public NativeElementWise
+    {
+    protected:
+        CpuIsa getIsa() const override { return get_cpu_isa(); }
+    };
+
+    REGISTER_KERNEL(Device::CPU, OpType::Add, SimdElementWise, "addSimd_CPU");
+    REGISTER_KERNEL(Device::CPU, OpType::Sub, SimdElementWise, "subSimd_CPU");
+    REGISTER_KERNEL(Device::CPU, OpType::Mul, SimdElementWise, "mulSimd_CPU");
+    REGISTER_KERNEL(Device::CPU, OpType::Div, SimdElementWise, "divSimd_CPU");
+    REGISTER_KERNEL(Device::CPU, OpType::Add, NativeElementWise, "addNaive_CPU",
+                    -1);
+    REGISTER_KERNEL(Device::CPU, OpType::Sub, NativeElementWise, "subNaive_CPU",
+                    -1);
+    REGISTER_KERNEL(Device::CPU, OpType::Mul, NativeElementWise, "mulNaive_CPU",
+                    -1);
+    REGISTER_KERNEL(Device::CPU, OpType::Div, NativeElementWise, "divNaive_CPU",
+                    -1);
 }; // namespace infini
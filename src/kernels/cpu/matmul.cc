@@ -0,0 +1,343 @@
+#include "operators/matmul.h"
+#include "core/kernel.h"
+#include "utils/simd.h"
+#include <algorithm>
+#include <cstring>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace infini {
+
+namespace {
+
+// Register block of the micro-kernel: MR rows of A times NR columns of B are
+// accumulated in registers (6x16 floats = 12 ymm accumulators on AVX2).
+constexpr size_t MR = 6, NR = 16;
+// Cache blocks: a KCxNR sliver of B stays in L1, an MCxKC block of packed A
+// stays in L2 and a KCxNC panel of packed B stays in L3.
+constexpr size_t KC = 256, MC = 72, NC = 4080;
+
+// A strided view of a row-major matrix. (i, j) lives at ptr[i * rs + j * cs],
+// so a transposed operand is just a view with swapped strides.
+struct MatView {
+    const float *ptr;
+    size_t rs, cs;
+    float at(size_t i, size_t j) const { return ptr[i * rs + j * cs]; }
+};
+
+// Pack an mc x kc block of A into MR-row panels stored k-major, zero-padding
+// the last panel so the micro-kernel never needs a row guard.
+void packA(const MatView &a, size_t mc, size_t kc, float *buf) {
+    for (size_t i0 = 0; i0 < mc; i0 += MR) {
+        size_t mr = std::min(MR, mc - i0);
+        for (size_t p = 0; p < kc; ++p) {
+            size_t i = 0;
+            for (; i < mr; ++i)
+                *buf++ = a.at(i0 + i, p);
+            for (; i < MR; ++i)
+                *buf++ = 0.f;
+        }
+    }
+}
+
+// Pack a kc x nc block of B into NR-column panels stored k-major.
+void packB(const MatView &b, size_t kc, size_t nc, float *buf) {
+    for (size_t j0 = 0; j0 < nc; j0 += NR) {
+        size_t nr = std::min(NR, nc - j0);
+        for (size_t p = 0; p < kc; ++p) {
+            size_t j = 0;
+            if (b.cs == 1) {
+                std::memcpy(buf, &b.ptr[p * b.rs + j0], nr * sizeof(float));
+                j = nr;
+            } else {
+                for (; j < nr; ++j)
+                    buf[j] = b.at(p, j0 + j);
+            }
+            for (; j < NR; ++j)
+                buf[j] = 0.f;
+            buf += NR;
+        }
+    }
+}
+
+// c[MR x NR] (+)= a_panel * b_panel, c has row stride ldc.
+void microKernelGeneric(size_t kc, const float *a, const float *b, float *c,
+                        size_t ldc, bool accumulate) {
+    float acc[MR][NR] = {};
+    for (size_t p = 0; p < kc; ++p, a += MR, b += NR)
+        for (size_t i = 0; i < MR; ++i)
+            for (size_t j = 0; j < NR; ++j)
+                acc[i][j] += a[i] * b[j];
+    for (size_t i = 0; i < MR; ++i)
+        for (size_t j = 0; j < NR; ++j)
+            c[i * ldc + j] = accumulate ? c[i * ldc + j] + acc[i][j]
+                                        : acc[i][j];
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+IT_TARGET_AVX2 inline void
+storeRowAvx2(float *dst, __m256 v0, __m256 v1, bool accumulate) {
+    if (accumulate) {
+        v0 = _mm256_add_ps(v0, _mm256_loadu_ps(dst));
+        v1 = _mm256_add_ps(v1, _mm256_loadu_ps(dst + 8));
+    }
+    _mm256_storeu_ps(dst, v0);
+    _mm256_storeu_ps(dst + 8, v1);
+}
+
+IT_TARGET_AVX2 void
+microKernelAvx2(size_t kc, const float *a, const float *b, float *c,
+                size_t ldc, bool accumulate) {
+    __m256 c00 = _mm256_setzero_ps(), c01 = _mm256_setzero_ps();
+    __m256 c10 = _mm256_setzero_ps(), c11 = _mm256_setzero_ps();
+    __m256 c20 = _mm256_setzero_ps(), c21 = _mm256_setzero_ps();
+    __m256 c30 = _mm256_setzero_ps(), c31 = _mm256_setzero_ps();
+    __m256 c40 = _mm256_setzero_ps(), c41 = _mm256_setzero_ps();
+    __m256 c50 = _mm256_setzero_ps(), c51 = _mm256_setzero_ps();
+    for (size_t p = 0; p < kc; ++p, a += MR, b += NR) {
+        __m256 b0 = _mm256_loadu_ps(b), b1 = _mm256_loadu_ps(b + 8);
+        __m256 ai;
+        ai = _mm256_broadcast_ss(a + 0);
+        c00 = _mm256_fmadd_ps(ai, b0, c00), c01 = _mm256_fmadd_ps(ai, b1, c01);
+        ai = _mm256_broadcast_ss(a + 1);
+        c10 = _mm256_fmadd_ps(ai, b0, c10), c11 = _mm256_fmadd_ps(ai, b1, c11);
+        ai = _mm256_broadcast_ss(a + 2);
+        c20 = _mm256_fmadd_ps(ai, b0, c20), c21 = _mm256_fmadd_ps(ai, b1, c21);
+        ai = _mm256_broadcast_ss(a + 3);
+        c30 = _mm256_fmadd_ps(ai, b0, c30), c31 = _mm256_fmadd_ps(ai, b1, c31);
+        ai = _mm256_broadcast_ss(a + 4);
+        c40 = _mm256_fmadd_ps(ai, b0, c40), c41 = _mm256_fmadd_ps(ai, b1, c41);
+        ai = _mm256_broadcast_ss(a + 5);
+        c50 = _mm256_fmadd_ps(ai, b0, c50), c51 = _mm256_fmadd_ps(ai, b1, c51);
+    }
+    storeRowAvx2(c + 0 * ldc, c00, c01, accumulate);
+    storeRowAvx2(c + 1 * ldc, c10, c11, accumulate);
+    storeRowAvx2(c + 2 * ldc, c20, c21, accumulate);
+    storeRowAvx2(c + 3 * ldc, c30, c31, accumulate);
+    storeRowAvx2(c + 4 * ldc, c40, c41, accumulate);
+    storeRowAvx2(c + 5 * ldc, c50, c51, accumulate);
+}
+#endif
+
+using MicroKernel = void (*)(size_t, const float *, const float *, float *,
+                             size_t, bool);
+
+MicroKernel selectMicroKernel() {
+#if defined(__x86_64__) || defined(__i386__)
+    if (get_cpu_isa() >= CpuIsa::AVX2)
+        return microKernelAvx2;
+#endif
+    return microKernelGeneric;
+}
+
+// C_i[m x n] = A_i[m x k] * B_i[k x n] for every product i of a batch, whose
+// operands start offA[i], offB[i] and offC[i] elements past a, b and c. C is
+// row-major with row stride ldc. The work is shared out over nThreads
+// threads by (product, MC block of A, chunk of NR panels of B), so a batch of
+// products with few rows still keeps every thread busy.
+void sgemm(size_t m, size_t n, size_t k, const MatView &a, const MatView &b,
+           float *c, size_t ldc, const vector<size_t> &offA,
+           const vector<size_t> &offB, const vector<size_t> &offC,
+           int nThreads) {
+    const MicroKernel microKernel = selectMicroKernel();
+    const size_t batch = offA.size();
+    if (m == 0 || n == 0)
+        return;
+    if (k == 0) {
+        for (size_t g = 0; g < batch; ++g)
+            for (size_t i = 0; i < m; ++i)
+                std::fill(c + offC[g] + i * ldc, c + offC[g] + i * ldc + n,
+                          0.f);
+        return;
+    }
+
+    // Products are packed and multiplied in groups just large enough to
+    // give every thread an MC block; the panels of B are split as well when
+    // the group still has fewer blocks than threads.
+    const size_t threads = std::max(nThreads, 1);
+    const size_t icBlocks = (m + MC - 1) / MC;
+    const size_t group = std::min(batch, (threads + icBlocks - 1) / icBlocks);
+    const size_t panelsMax = (std::min(NC, n) + NR - 1) / NR;
+    vector<float> bufB(group * panelsMax * NR * KC);
+
+#pragma omp parallel num_threads(nThreads) if (nThreads > 1)
+    {
+        vector<float> bufA(MC * KC);
+        float tile[MR * NR];
+        for (size_t g0 = 0; g0 < batch; g0 += group) {
+            const size_t gs = std::min(group, batch - g0);
+            const size_t blocks = gs * icBlocks;
+            for (size_t jc = 0; jc < n; jc += NC) {
+                const size_t nc = std::min(NC, n - jc);
+                const size_t panels = (nc + NR - 1) / NR;
+                const size_t chunks =
+                    std::min(panels, (threads + blocks - 1) / blocks);
+                const size_t chunk = (panels + chunks - 1) / chunks * NR;
+                for (size_t pc = 0; pc < k; pc += KC) {
+                    const size_t kc = std::min(KC, k - pc);
+#pragma omp for schedule(static)
+                    for (size_t t = 0; t < gs * panels; ++t) {
+                        size_t g = t / panels, jr = t % panels * NR;
+                        packB({b.ptr + offB[g0 + g] + pc * b.rs +
+                                   (jc + jr) * b.cs,
+                               b.rs, b.cs},
+                              kc, std::min(NR, nc - jr),
+                              bufB.data() + (g * panelsMax * NR + jr) * kc);
+                    }
+
+#pragma omp for schedule(static)
+                    for (size_t t = 0; t < blocks * chunks; ++t) {
+                        size_t g = t / chunks / icBlocks;
+                        size_t ic = t / chunks % icBlocks * MC;
+                        size_t mc = std::min(MC, m - ic);
+                        size_t jr0 = t % chunks * chunk;
+                        size_t jr1 = std::min(nc, jr0 + chunk);
+                        if (jr0 >= jr1)
+                            continue;
+                        packA({a.ptr + offA[g0 + g] + ic * a.rs + pc * a.cs,
+                               a.rs, a.cs},
+                              mc, kc, bufA.data());
+                        float *cg = c + offC[g0 + g] + ic * ldc + jc;
+                        const float *bg =
+                            bufB.data() + g * panelsMax * NR * kc;
+                        for (size_t jr = jr0; jr < jr1; jr += NR) {
+                            size_t nr = std::min(NR, nc - jr);
+                            for (size_t ir = 0; ir < mc; ir += MR) {
+                                size_t mr = std::min(MR, mc - ir);
+                                float *cij = cg + ir * ldc + jr;
+                                const float *ap = bufA.data() + ir * kc;
+                                const float *bp = bg + jr * kc;
+                                if (mr == MR && nr == NR) {
+                                    microKernel(kc, ap, bp, cij, ldc,
+                                                pc != 0);
+                                    continue;
+                                }
+                                // Edge tile: run the full kernel on a
+                                // scratch tile and copy back only the valid
+                                // part.
+                                microKernel(kc, ap, bp, tile, NR, false);
+                                for (size_t i = 0; i < mr; ++i)
+                                    for (size_t j = 0; j < nr; ++j)
+                                        cij[i * ldc + j] =
+                                            pc != 0 ? cij[i * ldc + j] +
+                                                          tile[i * NR + j]
+                                                    : tile[i * NR + j];
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+} // namespace
+
+class PackedMatmul : public CpuKernelWithParams {
+    struct Params : public KernelParams {
+        size_t m, n, k;
+        MatView viewA, viewB;
+        float *ptrC;
+        size_t ldc;
+        // Element offsets into A, B and C of every product.
+        vector<size_t> offA, offB, offC;
+    };
+
+    std::unique_ptr<KernelParams>
+    prepare(const Operator &_op, const RuntimeObj *context) const override {
+        auto op = as<MatmulObj>(_op);
+        IT_ASSERT(op->getDType() == DataType::Float32);
+        auto A = op->getInputs(0), B = op->getInputs(1), C = op->getOutput();
+        const auto shapeA = A->getDims(), shapeB = B->getDims(),
+                   shapeC = C->getDims();
+        const size_t m = op->getM(), n = op->getN(), k = op->getK();
+        const bool transA = op->getTransA(), transB = op->getTransB();
+        auto ptrA = A->getRawDataPtr<float *>(),
+             ptrB = B->getRawDataPtr<float *>();
+
+        // Batch broadcasting follows MatmulObj::inferShape: leading dims are
+        // right-aligned and size-1 dims are broadcast. A and B may be
+        // strided views (see supportsStrides), and C may have padded rows
+        // (see supportsOutputStrides).
+        const auto stridesA = A->getStrides(), stridesB = B->getStrides(),
+                   stridesC = C->getStrides();
+        const size_t rank = shapeC.size() - 2;
+        const size_t rankA = shapeA.size() - 2, rankB = shapeB.size() - 2;
+        Shape batchA(rank, 1), batchB(rank, 1);
+        std::copy(shapeA.begin(), shapeA.end() - 2, batchA.end() - rankA);
+        std::copy(shapeB.begin(), shapeB.end() - 2, batchB.end() - rankB);
+        vector<size_t> strideA(rank), strideB(rank);
+        size_t batch = 1;
+        for (size_t i = 0; i < rank; ++i) {
+            strideA[i] =
+                batchA[i] == 1 ? 0 : stridesA[i - (rank - rankA)];
+            strideB[i] =
+                batchB[i] == 1 ? 0 : stridesB[i - (rank - rankB)];
+            batch *= shapeC[i];
+        }
+
+        // Element (i, j) of op(A) is A[.., i, j], or A[.., j, i] if
+        // transposed; likewise for B.
+        const size_t rsA = stridesA[rankA], csA = stridesA[rankA + 1];
+        const size_t rsB = stridesB[rankB], csB = stridesB[rankB + 1];
+        auto p = std::make_unique<Params>();
+        p->m = m, p->n = n, p->k = k;
+        p->viewA = transA ? MatView{ptrA, csA, rsA} : MatView{ptrA, rsA, csA};
+        p->viewB = transB ? MatView{ptrB, csB, rsB} : MatView{ptrB, rsB, csB};
+        p->ptrC = C->getRawDataPtr<float *>();
+        p->ldc = stridesC[rank];
+
+        // A single B shared by every batch of a dense, non-transposed A:
+        // fold the batches into M so B is packed only once.
+        bool bShared = std::all_of(strideB.begin(), strideB.end(),
+                                   [](size_t s) { return s == 0; });
+        bool aDense = std::equal(batchA.begin(), batchA.end(),
+                                 shapeC.begin()) &&
+                      A->isContiguous();
+        if (bShared && aDense && !transA) {
+            p->m = batch * m;
+            p->offA = p->offB = p->offC = {0};
+            return p;
+        }
+
+        for (size_t b = 0; b < batch; ++b) {
+            size_t offA = 0, offB = 0, offC = 0;
+            for (size_t i = rank, rest = b; i-- > 0;) {
+                size_t idx = rest % shapeC[i];
+                rest /= shapeC[i];
+                offA += idx * strideA[i];
+                offB += idx * strideB[i];
+                offC += idx * stridesC[i];
+            }
+            p->offA.emplace_back(offA);
+            p->offB.emplace_back(offB);
+            p->offC.emplace_back(offC);
+        }
+        return p;
+    }
+
+    void execute(const KernelParams &params,
+                 const RuntimeObj *context) const override {
+        auto &p = static_cast<const Params &>(params);
+        // For the threading policy a multiply-add is weighted like a byte of
+        // streamed data.
+        const int nThreads =
+            getNumThreads(context, p.offA.size() * p.m * p.n * p.k);
+        sgemm(p.m, p.n, p.k, p.viewA, p.viewB, p.ptrC, p.ldc, p.offA, p.offB,
+              p.offC, nThreads);
+    }
+
+    bool supportsStrides(const Operator &op, int input) const override {
+        return true;
+    }
+
+    bool supportsOutputStrides(const Operator &op) const override {
+        return true;
+    }
+};
+
+REGISTER_KERNEL(Device::CPU, OpType::MatMul, PackedMatmul,
+                "MatmulPacked_CPU");
+
+} // namespace infini
@@ -1,8 +1,173 @@
 #include "operators/transpose.h"
 #include "core/kernel.h"
+#include "utils/simd.h"
+#include <cstring>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 namespace infini {
 
+namespace {
+
+// Edge of the square blocks the 2D transpose is tiled into. A block of
+// 4-byte elements is 4KB on each side, which keeps source and destination
+// in L1 while the block is transposed.
+constexpr size_t TB = 32;
+
+// Transpose a rows x cols block: src[i * ls + j] -> dst[j * ld + i].
+template <typename T>
+void transposeBlock(const T *src, T *dst, size_t rows, size_t cols, size_t ls,
+                    size_t ld) {
+    for (size_t i = 0; i < rows; ++i)
+        for (size_t j = 0; j < cols; ++j)
+            dst[j * ld + i] = src[i * ls + j];
+}
+
+// Same as above for elements of arbitrary byte size (e.g. a folded
+// contiguous inner run).
+void transposeBlockBytes(const uint8_t *src, uint8_t *dst, size_t rows,
+                         size_t cols, size_t ls, size_t ld, size_t esize) {
+    for (size_t i = 0; i < rows; ++i)
+        for (size_t j = 0; j < cols; ++j)
+            std::memcpy(dst + (j * ld + i) * esize,
+                        src + (i * ls + j) * esize, esize);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// In-register 8x8 transpose of 4-byte elements.
+IT_TARGET_AVX2 void transpose8x8Avx(const float *src, float *dst, size_t ls,
+                                    size_t ld) {
+    __m256 r0 = _mm256_loadu_ps(src + 0 * ls), r1 = _mm256_loadu_ps(src + 1 * ls);
+    __m256 r2 = _mm256_loadu_ps(src + 2 * ls), r3 = _mm256_loadu_ps(src + 3 * ls);
+    __m256 r4 = _mm256_loadu_ps(src + 4 * ls), r5 = _mm256_loadu_ps(src + 5 * ls);
+    __m256 r6 = _mm256_loadu_ps(src + 6 * ls), r7 = _mm256_loadu_ps(src + 7 * ls);
+    __m256 t0 = _mm256_unpacklo_ps(r0, r1), t1 = _mm256_unpackhi_ps(r0, r1);
+    __m256 t2 = _mm256_unpacklo_ps(r2, r3), t3 = _mm256_unpackhi_ps(r2, r3);
+    __m256 t4 = _mm256_unpacklo_ps(r4, r5), t5 = _mm256_unpackhi_ps(r4, r5);
+    __m256 t6 = _mm256_unpacklo_ps(r6, r7), t7 = _mm256_unpackhi_ps(r6, r7);
+    __m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+    __m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+    __m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+    __m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+    _mm256_storeu_ps(dst + 0 * ld, _mm256_permute2f128_ps(s0, s4, 0x20));
+    _mm256_storeu_ps(dst + 1 * ld, _mm256_permute2f128_ps(s1, s5, 0x20));
+    _mm256_storeu_ps(dst + 2 * ld, _mm256_permute2f128_ps(s2, s6, 0x20));
+    _mm256_storeu_ps(dst + 3 * ld, _mm256_permute2f128_ps(s3, s7, 0x20));
+    _mm256_storeu_ps(dst + 4 * ld, _mm256_permute2f128_ps(s0, s4, 0x31));
+    _mm256_storeu_ps(dst + 5 * ld, _mm256_permute2f128_ps(s1, s5, 0x31));
+    _mm256_storeu_ps(dst + 6 * ld, _mm256_permute2f128_ps(s2, s6, 0x31));
+    _mm256_storeu_ps(dst + 7 * ld, _mm256_permute2f128_ps(s3, s7, 0x31));
+}
+
+IT_TARGET_AVX2 void transposeBlockAvx(const float *src, float *dst,
+                                      size_t rows, size_t cols, size_t ls,
+                                      size_t ld) {
+    size_t rows8 = rows / 8 * 8, cols8 = cols / 8 * 8;
+    for (size_t i = 0; i < rows8; i += 8)
+        for (size_t j = 0; j < cols8; j += 8)
+            transpose8x8Avx(src + i * ls + j, dst + j * ld + i, ls, ld);
+    if (cols8 < cols)
+        transposeBlock(src + cols8, dst + cols8 * ld, rows, cols - cols8, ls,
+                       ld);
+    if (rows8 < rows)
+        transposeBlock(src + rows8 * ls, dst + rows8, rows - rows8, cols8, ls,
+                       ld);
+}
+#endif
+
+/**
+ * @brief A transpose reduced to its simplest equivalent form: size-1 dims
+ * are dropped, input dims that stay adjacent after the permutation are
+ * merged, and an unchanged innermost dim is folded into the element size.
+ */
+struct TransposePlan {
+    vector<size_t> dims; // reduced input dims
+    vector<int> perm;    // output dim j comes from input dim perm[j]
+    size_t esize;        // bytes per (possibly folded) element
+
+    TransposePlan(const Shape &inDims, const vector<int> &permute,
+                  size_t elemSize)
+        : esize(elemSize) {
+        const int rank = inDims.size();
+        // Map every kept input dim to its reduced index.
+        vector<int> newIdx(rank, -1);
+        vector<int> kept;
+        for (int d = 0; d < rank; ++d)
+            if (inDims[d] != 1) {
+                newIdx[d] = kept.size();
+                kept.emplace_back(d);
+            }
+        vector<int> p;
+        for (int d : permute)
+            if (newIdx[d] >= 0)
+                p.emplace_back(newIdx[d]);
+        // Merge input dims d, d+1 when they are also adjacent in p.
+        vector<size_t> sz;
+        for (int d : kept)
+            sz.emplace_back(inDims[d]);
+        vector<int> head(p.size());
+        for (size_t j = 0; j < p.size(); ++j)
+            head[j] = j == 0 || p[j] != p[j - 1] + 1;
+        vector<int> group(sz.size(), -1);
+        for (size_t j = 0; j < p.size(); ++j)
+            if (head[j])
+                group[p[j]] = p[j];
+            else
+                group[p[j]] = group[p[j - 1]];
+        vector<int> groupIdx(sz.size(), -1);
+        for (size_t d = 0; d < sz.size(); ++d)
+            if (group[d] == (int)d) {
+                groupIdx[d] = dims.size();
+                dims.emplace_back(sz[d]);
+            } else
+                dims[groupIdx[group[d]]] *= sz[d];
+        for (size_t j = 0; j < p.size(); ++j)
+            if (head[j])
+                perm.emplace_back(groupIdx[p[j]]);
+        if (!perm.empty() && perm.back() == (int)dims.size() - 1) {
+            esize *= dims.back();
+            dims.pop_back();
+            perm.pop_back();
+        }
+    }
+};
+
+void transposeBlockDispatch(const uint8_t *src, uint8_t *dst, size_t rows,
+                            size_t cols, size_t ls, size_t ld, size_t esize,
+                            bool useAvx) {
+    switch (esize) {
+    case 1:
+        return transposeBlock(src, dst, rows, cols, ls, ld);
+    case 2:
+        return transposeBlock(reinterpret_cast<const uint16_t *>(src),
+                              reinterpret_cast<uint16_t *>(dst), rows, cols,
+                              ls, ld);
+    case 4:
+#if defined(__x86_64__) || defined(__i386__)
+        if (useAvx)
+            return transposeBlockAvx(reinterpret_cast<const float *>(src),
+                                     reinterpret_cast<float *>(dst), rows,
+                                     cols, ls, ld);
+#endif
+        return transposeBlock(reinterpret_cast<const uint32_t *>(src),
+                              reinterpret_cast<uint32_t *>(dst), rows, cols,
+                              ls, ld);
+    case 8:
+        return transposeBlock(reinterpret_cast<const uint64_t *>(src),
+                              reinterpret_cast<uint64_t *>(dst), rows, cols,
+                              ls, ld);
+    default:
+        return transposeBlockBytes(src, dst, rows, cols, ls, ld, esize);
+    }
+}
+
+} // namespace
+
 inline Shape idx2Pos(const Shape &shape, size_t idx) {
     Shape pos = Shape(shape.size(), 0);
     auto rest = idx, curDimId = shape.size() - 1;
@@ -25,7 +190,8 @@ class NaiveTranspose : public CpuKernelWithoutConfig {
         size_t inSize = inputs[0]->size();
         auto inPtr = inputs[0]->getRawDataPtr<T *>(),
              outPtr = outputs[0]->getRawDataPtr<T *>();
-        // #pragma omp parallel for
+        const int nThreads = getNumThreads(context, inputs[0]->getBytes());
+#pragma omp parallel for num_threads(nThreads) if (nThreads > 1)
         for (size_t inIdx = 0; inIdx < inSize; ++inIdx) {
             auto posInput = idx2Pos(inDim, inIdx);
             int outIdx = 0;
@@ -38,23 +204,110 @@ class NaiveTranspose : public CpuKernelWithoutConfig {
 
     void compute(const Operator &_op,
                  const RuntimeObj *context) const override {
-#define CASE(N)                                                                \
-    case N:                                                                    \
-        doCompute<DT<N>::t>(_op, context)
-
-        int dataTypeIdx = _op->getDType().getIndex();
-        switch (dataTypeIdx) {
-            CASE(1); // DataType::Float32
-            break;
-            CASE(12); // DataType::UInt32
-            break;
-        default:
-            IT_TODO_HALT();
+        dispatchDType(AllDTypes{}, _op->getDType(), [&](auto tag) {
+            doCompute<typename decltype(tag)::t>(_op, context);
+        });
+    }
+};
+
+class TiledTranspose : public CpuKernelWithParams {
+    struct Params : public KernelParams {
+        const uint8_t *src;
+        uint8_t *dst;
+        size_t bytes, esize;
+        // Rows and cols of the tiled dims and their strides.
+        size_t rows, cols, ls, ld;
+        // Remaining dims with their input and output strides, outermost
+        // first.
+        vector<size_t> batchDims, batchSrcStride, batchDstStride;
+        bool useAvx;
+    };
+
+    std::unique_ptr<KernelParams>
+    prepare(const Operator &_op, const RuntimeObj *context) const override {
+        auto op = as<TransposeObj>(_op);
+        auto input = op->getInputs(0), output = op->getOutput();
+        auto p = std::make_unique<Params>();
+        p->src = input->getRawDataPtr<uint8_t *>();
+        p->dst = output->getRawDataPtr<uint8_t *>();
+        p->bytes = input->getBytes();
+        TransposePlan plan(input->getDims(), op->getPermute(),
+                           input->getDType().getSize());
+        p->esize = plan.esize;
+        p->useAvx = get_cpu_isa() >= CpuIsa::AVX2;
+
+        // A rank <= 1 plan is a plain copy, marked by rows == 0.
+        const size_t rank = plan.dims.size();
+        if (rank <= 1) {
+            p->rows = p->cols = 0;
+            return p;
+        }
+
+        // The output innermost dim `a` is read with stride inStride[a] and
+        // the input innermost dim `rank - 1` is written with stride
+        // dstStride[rank - 1]; tile over these two and loop over the rest.
+        vector<size_t> inStride(rank), dstStride(rank);
+        for (size_t d = rank, s = 1; d-- > 0; s *= plan.dims[d])
+            inStride[d] = s;
+        for (size_t j = rank, s = 1; j-- > 0; s *= plan.dims[plan.perm[j]])
+            dstStride[plan.perm[j]] = s;
+        const size_t a = plan.perm.back(), c = rank - 1;
+        p->rows = plan.dims[a];
+        p->cols = plan.dims[c];
+        p->ls = inStride[a];
+        p->ld = dstStride[c];
+        for (size_t d = 0; d < rank; ++d)
+            if (d != a && d != c) {
+                p->batchDims.emplace_back(plan.dims[d]);
+                p->batchSrcStride.emplace_back(inStride[d]);
+                p->batchDstStride.emplace_back(dstStride[d]);
+            }
+        return p;
+    }
+
+    void execute(const KernelParams &params,
+                 const RuntimeObj *context) const override {
+        auto &p = static_cast<const Params &>(params);
+        if (p.rows == 0) {
+            std::memcpy(p.dst, p.src, p.bytes);
+            return;
+        }
+
+        const size_t rows = p.rows, cols = p.cols, ls = p.ls, ld = p.ld;
+        size_t batch = 1;
+        for (auto d : p.batchDims)
+            batch *= d;
+        const size_t rowBlocks = (rows + TB - 1) / TB;
+        const size_t colBlocks = (cols + TB - 1) / TB;
+        const size_t nBlocks = batch * rowBlocks * colBlocks;
+        const size_t esize = p.esize;
+        const int nThreads = getNumThreads(context, p.bytes);
+
+#pragma omp parallel for schedule(static) num_threads(nThreads)             \
+    if (nThreads > 1)
+        for (size_t blk = 0; blk < nBlocks; ++blk) {
+            size_t rest = blk / (rowBlocks * colBlocks);
+            size_t i0 = blk / colBlocks % rowBlocks * TB;
+            size_t j0 = blk % colBlocks * TB;
+            size_t srcOff = i0 * ls + j0, dstOff = j0 * ld + i0;
+            for (size_t k = p.batchDims.size(); k-- > 0;) {
+                size_t idx = rest % p.batchDims[k];
+                rest /= p.batchDims[k];
+                srcOff += idx * p.batchSrcStride[k];
+                dstOff += idx * p.batchDstStride[k];
+            }
+            transposeBlockDispatch(p.src + srcOff * esize,
+                                   p.dst + dstOff * esize,
+                                   std::min(TB, rows - i0),
+                                   std::min(TB, cols - j0), ls, ld, esize,
+                                   p.useAvx);
         }
     }
 };
 
+REGISTER_KERNEL(Device::CPU, OpType::Transpose, TiledTranspose,
+                "TransposeTiled_CPU");
 REGISTER_KERNEL(Device::CPU, OpType::Transpose, NaiveTranspose,
-                "TransposeNaive_CPU");
+                "TransposeNaive_CPU", -1);
 
 } // namespace infini
@@ -1,105 +1,250 @@
 #include "operators/unary.h"
 #include "core/kernel.h"
+#include "utils/fp16.h"
+#include "utils/simd.h"
+#include <cmath>
+#include <cstring>
+#include <limits>
 
 namespace infini
 {
-    class NativeUnary : public CpuKernelWithoutConfig
+    // Clamps to [lo, hi] with compare-and-select, which compiles to min/max
+    // instructions; a missing bound is dropped at compile time. NaNs pass
+    // through since every comparison with them is false.
+    //
+    // Float16 and BFloat16 values are clamped as int16 keys: flipping the
+    // magnitude bits of negative numbers makes the bit pattern order like
+    // the value, so no conversion to float is needed. `lo` and `hi` are
+    // given as keys.
+    template <typename Tag>
+    constexpr bool isHalf =
+        std::is_same_v<Tag, DT<10>> || std::is_same_v<Tag, DT<16>>;
+    // Magnitudes above the bits of infinity are nans.
+    template <typename Tag>
+    constexpr int halfInf = std::is_same_v<Tag, DT<10>> ? 0x7c00 : 0x7f80;
+
+    template <bool HasLo, bool HasHi, typename Tag>
+    struct ClampCompute
     {
         template <typename T>
-        static T reluCompute(T val)
+        static IT_SIMD_INLINE void clamp(T &out, const T &lo, const T &hi)
         {
-            return std::max(T(0), val);
+            if constexpr (HasLo)
+                out = out < lo ? lo : out;
+            if constexpr (HasHi)
+                out = out > hi ? hi : out;
         }
 
         template <typename T>
-        void doCompute(const Operator &_op, const RuntimeObj *context) const
+        static IT_SIMD_INLINE void apply(T &out, const T &val, const T &lo,
+                                         const T &hi)
+        {
+            if constexpr (isHalf<Tag>)
+            {
+                T key = val ^ ((val >> 15) & 0x7fff);
+                clamp(key, lo, hi);
+                key = key ^ ((key >> 15) & 0x7fff);
+                out = (val & 0x7fff) > halfInf<Tag> ? val : key;
+            }
+            else
+            {
+                out = val;
+                clamp(out, lo, hi);
+            }
+        }
+    };
+
+    template <typename T>
+    using ClampFunc = void (*)(T *out, const T *in, size_t n, T lo, T hi);
+
+    template <typename Op, typename T>
+    static void clampRunScalar(T *out, const T *in, size_t n, T lo, T hi)
+    {
+        for (size_t i = 0; i < n; ++i)
+            Op::apply(out[i], in[i], lo, hi);
+    }
+
+    template <typename Op, typename T, size_t Bytes>
+    static IT_SIMD_INLINE void clampRun(T *out, const T *in, size_t n, T lo,
+                                        T hi)
+    {
+        using V = typename SimdVec<T, Bytes>::type;
+        constexpr size_t lanes = SimdVec<T, Bytes>::lanes;
+        V v, vlo, vhi, res;
+        simd_broadcast(vlo, lo);
+        simd_broadcast(vhi, hi);
+        size_t i = 0;
+        for (; i + lanes <= n; i += lanes)
         {
-            auto op = as<UnaryObj>(_op);
-            T *inptr = op->getInputs(0)->getRawDataPtr<T *>();
-            T *outptr = op->getOutput()->getRawDataPtr<T *>();
+            simd_load(v, in + i);
+            Op::apply(res, v, vlo, vhi);
+            simd_store(out + i, res);
+        }
+        clampRunScalar<Op>(out + i, in + i, n - i, lo, hi);
+    }
+
+#define DEFINE_CLAMP_RUN(isa, target)                                         \
+    template <typename Op, typename T>                                        \
+    target void clampRun##isa(T *out, const T *in, size_t n, T lo, T hi)      \
+    {                                                                         \
+        clampRun<Op, T, SimdWidth<CpuIsa::isa>::bytes>(out, in, n, lo, hi);   \
+    }
+
+    DEFINE_CLAMP_RUN(SSE, IT_TARGET_SSE)
+    DEFINE_CLAMP_RUN(AVX2, IT_TARGET_AVX2)
+    DEFINE_CLAMP_RUN(AVX512, IT_TARGET_AVX512)
+#undef DEFINE_CLAMP_RUN
+
+    // Elements per parallel task.
+    constexpr size_t CLAMP_BLOCK = 1 << 16;
 
-            auto outDim = op->getOutput()->getDims();
-            auto n = op->getOutput()->size();
+    using ClipDTypes = DTypeList<1, 2, 3, 4, 5, 6, 7, 10, 11, 12, 13, 16>;
 
-            T (*_doCompute)
-            (T val);
-            switch (op->getOpType().underlying())
+    /**
+     * @brief Vectorized Relu and Clip. Relu is a Clip to [0, inf); both
+     * run as branch-free min/max over the widest ISA from get_cpu_isa().
+     */
+    class SimdClip : public CpuKernelWithParams
+    {
+        struct Params : public KernelParams
+        {
+            void *out;
+            const void *in;
+            size_t n, bytes;
+            CpuIsa isa;
+            // Bytes of the T bounds, keys for half precision.
+            char lo[8], hi[8];
+            void (*exec)(const Params &params, int nThreads);
+        };
+
+        // Converts a float bound to T: integer bounds are rounded inwards
+        // and saturated, half bounds are turned into clamp keys.
+        template <typename T, typename Tag>
+        static T toBound(float v, bool isLo)
+        {
+            if constexpr (isHalf<Tag>)
             {
-            case OpType::Relu:
-                _doCompute = reluCompute<T>;
-                break;
-            default:
-                IT_TODO_HALT();
+                int16_t h = std::is_same_v<Tag, DT<10>> ? float_to_fp16(v)
+                                                        : float_to_bf16(v);
+                return h ^ ((h >> 15) & 0x7fff);
             }
-
-            for (size_t offset = 0; offset < n; offset++)
+            else if constexpr (std::is_integral_v<T>)
             {
-                outptr[offset] = _doCompute(inptr[offset]);
+                // The limits of T are compared as powers of two: the max
+                // of a 64-bit T rounds up to 2^64 (or 2^63) in double.
+                double d = isLo ? std::ceil(v) : std::floor(v);
+                if (d >= std::ldexp(1.0, std::numeric_limits<T>::digits))
+                    return std::numeric_limits<T>::max();
+                if (d <= (double)std::numeric_limits<T>::min())
+                    return std::numeric_limits<T>::min();
+                return T(d);
             }
+            else
+                return T(v);
         }
 
-        void compute(const Operator &_op,
-                     const RuntimeObj *context) const override
+        template <typename Op, typename T>
+        static ClampFunc<T> getClampFunc(CpuIsa isa)
         {
-#define CASE(N) \
-    case N:     \
-        doCompute<DT<N>::t>(_op, context)
-
-            int dataTypeIdx = _op->getDType().getIndex();
-            switch (dataTypeIdx)
+            switch (isa)
             {
-                CASE(1); // DataType::Float32
-                break;
-                CASE(12); // DataType::UInt32
-                break;
+            case CpuIsa::AVX512:
+                return clampRunAVX512<Op, T>;
+            case CpuIsa::AVX2:
+                return clampRunAVX2<Op, T>;
+            case CpuIsa::SSE:
+                return clampRunSSE<Op, T>;
             default:
-                IT_TODO_HALT();
+                return clampRunScalar<Op, T>;
             }
         }
-    };
 
-    class Clip : public CpuKernelWithoutConfig
-    {
         template <typename T>
-        void doCompute(const Operator &_op, const RuntimeObj *context) const
+        static void copy(const Params &p, int)
         {
-            auto op = as<ClipObj>(_op);
-            T *inptr = op->getInputs(0)->getRawDataPtr<T *>();
-            T *outptr = op->getOutput()->getRawDataPtr<T *>();
-            auto minValue = op->getMin();
-            auto maxValue = op->getMax();
-
-            auto n = op->getOutput()->size();
-            for (size_t offset = 0; offset < n; offset++)
+            if (p.out != p.in)
+                std::memcpy(p.out, p.in, p.n * sizeof(T));
+        }
+
+        template <typename T, typename Op>
+        static void exec(const Params &p, int nThreads)
+        {
+            ClampFunc<T> run = getClampFunc<Op, T>(p.isa);
+            auto inptr = static_cast<const T *>(p.in);
+            auto outptr = static_cast<T *>(p.out);
+            T lo, hi;
+            std::memcpy(&lo, p.lo, sizeof(T));
+            std::memcpy(&hi, p.hi, sizeof(T));
+            const size_t n = p.n;
+            const long nBlocks = (n + CLAMP_BLOCK - 1) / CLAMP_BLOCK;
+#pragma omp parallel for schedule(static) num_threads(nThreads)              \
+    if (nThreads > 1)
+            for (long b = 0; b < nBlocks; ++b)
             {
-                auto val = *inptr++;
-                *outptr++ = (minValue && val < *minValue)   ? *minValue
-                            : (maxValue && val > *maxValue) ? *maxValue
-                                                            : val;
+                size_t begin = b * CLAMP_BLOCK;
+                run(outptr + begin, inptr + begin,
+                    std::min(CLAMP_BLOCK, n - begin), lo, hi);
             }
         }
 
-        void compute(const Operator &_op,
-                     const RuntimeObj *context) const override
+        template <typename Tag>
+        static void doPrepare(const Operator &_op, Params &p)
         {
-#define CASE(N) \
-    case N:     \
-        doCompute<DT<N>::t>(_op, context)
-
-            int dataTypeIdx = _op->getDType().getIndex();
-            switch (dataTypeIdx)
+            // Half precision is clamped on signed keys of its bits.
+            using T = std::conditional_t<isHalf<Tag>, int16_t,
+                                         typename Tag::t>;
+            std::optional<float> minValue, maxValue;
+            if (_op->getOpType() == OpType::Relu)
+                minValue = 0.f;
+            else
             {
-                CASE(1); // DataType::Float32
-                break;
-                CASE(12); // DataType::UInt32
-                break;
-            default:
-                IT_TODO_HALT();
+                auto op = as<ClipObj>(_op);
+                minValue = op->getMin();
+                maxValue = op->getMax();
             }
+            p.n = _op->getOutput()->size();
+            p.bytes = 2 * p.n * sizeof(T);
+            T lo = minValue ? toBound<T, Tag>(*minValue, true) : T(0);
+            T hi = maxValue ? toBound<T, Tag>(*maxValue, false) : T(0);
+            std::memcpy(p.lo, &lo, sizeof(T));
+            std::memcpy(p.hi, &hi, sizeof(T));
+            if (minValue && maxValue)
+                p.exec = exec<T, ClampCompute<true, true, Tag>>;
+            else if (minValue)
+                p.exec = exec<T, ClampCompute<true, false, Tag>>;
+            else if (maxValue)
+                p.exec = exec<T, ClampCompute<false, true, Tag>>;
+            else
+                p.exec = copy<T>;
+        }
+
+    public:
+        std::unique_ptr<KernelParams>
+        prepare(const Operator &_op, const RuntimeObj *context) const override
+        {
+            auto p = std::make_unique<Params>();
+            p->in = _op->getInputs(0)->getRawDataPtr<void *>();
+            p->out = _op->getOutput()->getRawDataPtr<void *>();
+            p->isa = get_cpu_isa();
+            dispatchDType(ClipDTypes{}, _op->getDType(), [&](auto tag)
+                          { doPrepare<decltype(tag)>(_op, *p); });
+            return p;
+        }
+
+        void execute(const KernelParams &params,
+                     const RuntimeObj *context) const override
+        {
+            auto &p = static_cast<const Params &>(params);
+            p.exec(p, getNumThreads(context, p.bytes));
+        }
+
+        bool supportsInPlace(const Operator &op, int input) const override
+        {
+            return sameLayout(op, input);
         }
     };
 
-    REGISTER_KERNEL(Device::CPU, OpType::Relu, NativeUnary, "reluNaive_CPU");
-    REGISTER_KERNEL(Device::CPU, OpType::Clip, Clip, "Clip_CPU");
+    REGISTER_KERNEL(Device::CPU, OpType::Relu, SimdClip, "reluSimd_CPU");
+    REGISTER_KERNEL(Device::CPU, OpType::Clip, SimdClip, "clipSimd_CPU");
 
 }; // namespace infini
@@ -0,0 +1,77 @@
+#include "utils/cpu_isa.h"
+#include "core/common.h"
+#include <algorithm>
+#include <atomic>
+
+namespace infini {
+
+CpuIsa detect_cpu_isa() {
+    static const CpuIsa detected = [] {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f") &&
+            __builtin_cpu_supports("avx512bw") &&
+            __builtin_cpu_supports("avx512dq") &&
+            __builtin_cpu_supports("avx512vl"))
+            return CpuIsa::AVX512;
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+            return CpuIsa::AVX2;
+        if (__builtin_cpu_supports("sse4.1"))
+            return CpuIsa::SSE;
+#endif
+        return CpuIsa::Scalar;
+    }();
+    return detected;
+}
+
+static std::atomic<CpuIsa> &current_cpu_isa() {
+    static std::atomic<CpuIsa> isa{detect_cpu_isa()};
+    return isa;
+}
+
+CpuIsa get_cpu_isa() { return current_cpu_isa().load(std::memory_order_relaxed); }
+
+void set_cpu_isa(CpuIsa isa) {
+    current_cpu_isa().store(std::min(isa, detect_cpu_isa()));
+}
+
+bool cpu_has_f16c() {
+#if defined(__x86_64__) || defined(__i386__)
+    static const bool supported = [] {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("f16c") != 0;
+    }();
+    return supported && get_cpu_isa() >= CpuIsa::AVX2;
+#else
+    return false;
+#endif
+}
+
+bool cpu_has_avx512_bf16() {
+#if defined(__x86_64__) || defined(__i386__)
+    static const bool supported = [] {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx512bf16") != 0;
+    }();
+    return supported && get_cpu_isa() >= CpuIsa::AVX512;
+#else
+    return false;
+#endif
+}
+
+std::string cpu_isa_str(CpuIsa isa) {
+    switch (isa) {
+    case CpuIsa::Scalar:
+        return "Scalar";
+    case CpuIsa::SSE:
+        return "SSE";
+    case CpuIsa::AVX2:
+        return "AVX2";
+    case CpuIsa::AVX512:
+        return "AVX512";
+    default:
+        IT_TODO_HALT();
+    }
+}
+
+} // namespace infini
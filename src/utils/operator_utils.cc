@@ -67,6 +67,54 @@ size_t delocate_index(const Shape &shapeIndex, const Shape &shape,
     return ans;
 }
 
+BroadcastIterator::BroadcastIterator(const Shape &output,
+                                     const vector<Shape> &inputs)
+    : strides(inputs.size()) {
+    const size_t rank = output.size();
+    // Dense strides of every input right-aligned to the output, 0 on the
+    // broadcast axes.
+    vector<vector<size_t>> full(inputs.size(), vector<size_t>(rank, 0));
+    for (size_t k = 0; k < inputs.size(); ++k) {
+        const auto &shape = inputs[k];
+        IT_ASSERT(shape.size() <= rank);
+        size_t stride = 1;
+        for (size_t i = rank, j = shape.size(); j-- > 0;) {
+            --i;
+            IT_ASSERT(shape[j] == output[i] || shape[j] == 1);
+            if (shape[j] != 1)
+                full[k][i] = stride;
+            stride *= shape[j];
+        }
+    }
+
+    for (size_t i = 0; i < rank; ++i) {
+        if (output[i] == 1)
+            continue;
+        bool mergeable = !dims.empty();
+        for (size_t k = 0; mergeable && k < inputs.size(); ++k)
+            mergeable = strides[k].back() == full[k][i] * output[i];
+        if (mergeable) {
+            dims.back() *= output[i];
+            for (size_t k = 0; k < inputs.size(); ++k)
+                strides[k].back() = full[k][i];
+        } else {
+            dims.emplace_back(output[i]);
+            for (size_t k = 0; k < inputs.size(); ++k)
+                strides[k].emplace_back(full[k][i]);
+        }
+    }
+    if (dims.empty()) {
+        dims.emplace_back(1);
+        for (auto &s : strides)
+            s.emplace_back(0);
+    }
+}
+
+size_t BroadcastIterator::numRuns() const {
+    return std::accumulate(dims.begin(), dims.end() - 1, (size_t)1,
+                           std::multiplies<size_t>());
+}
+
 std::string device_to_str(Device device) {
     std::string deviceStr;
     switch (device) {
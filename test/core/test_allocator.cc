@@ -71,4 +71,71 @@ namespace infini
         EXPECT_EQ(ptr1, ptr2);
     }
 
+    TEST(Allocator, testBestFitSplit)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Allocator allocator = Allocator(runtime);
+        allocator.setAlignment(8);
+        size_t a = allocator.alloc(64);
+        allocator.alloc(8);
+        size_t c = allocator.alloc(32);
+        allocator.alloc(8);
+        allocator.free(a, 64);
+        allocator.free(c, 32);
+        // the smaller hole fits best, and what is left of it is reused
+        EXPECT_EQ(allocator.alloc(16), c);
+        EXPECT_EQ(allocator.alloc(16), c + 16);
+        EXPECT_EQ(allocator.alloc(40), a);
+        EXPECT_EQ(allocator.alloc(24), a + 40);
+        EXPECT_EQ(allocator.getPeak(), 112u);
+    }
+
+    TEST(Allocator, testCoalesce)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Allocator allocator = Allocator(runtime);
+        allocator.setAlignment(8);
+        size_t a = allocator.alloc(16);
+        size_t b = allocator.alloc(16);
+        size_t c = allocator.alloc(16);
+        allocator.alloc(16);
+        // merged with the left and then the right neighbor
+        allocator.free(a, 16);
+        allocator.free(c, 16);
+        allocator.free(b, 16);
+        EXPECT_EQ(allocator.alloc(48), a);
+        EXPECT_EQ(allocator.getPeak(), 64u);
+        allocator.info();
+    }
+
+    TEST(Allocator, testCoalesceIntoTail)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Allocator allocator = Allocator(runtime);
+        allocator.setAlignment(8);
+        allocator.alloc(16);
+        size_t b = allocator.alloc(16);
+        size_t c = allocator.alloc(16);
+        allocator.free(b, 16);
+        allocator.free(c, 16);
+        // b and c went back to the tail, which grows in place
+        EXPECT_EQ(allocator.alloc(40), b);
+        EXPECT_EQ(allocator.getPeak(), 56u);
+        EXPECT_EQ(allocator.getUsed(), 56u);
+    }
+
+    TEST(Allocator, testAlignment)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Allocator allocator = Allocator(runtime);
+        EXPECT_EQ(allocator.getAlignment(), 64u);
+        EXPECT_EQ(allocator.alloc(4), 0u);
+        EXPECT_EQ(allocator.alloc(100), 64u);
+        EXPECT_EQ(allocator.getPeak(), 192u);
+        allocator.alignBase(4096);
+        auto ptr = reinterpret_cast<uintptr_t>(allocator.getPtr());
+        EXPECT_EQ(ptr % 4096, 0u);
+        EXPECT_THROW(allocator.setAlignment(128), Exception);
+    }
+
 } // namespace infini
@@ -0,0 +1,89 @@
+#include "core/batcher.h"
+#include "core/runtime.h"
+#include "operators/element_wise.h"
+#include "operators/matmul.h"
+#include "operators/transpose.h"
+#include "operators/unary.h"
+
+#include "test.h"
+
+namespace infini
+{
+    TEST(DynamicBatcher, MatchesSingleRuns)
+    {
+        auto runtime = make_ref<NativeCpuRuntimeObj>();
+        Graph g = make_ref<GraphObj>(runtime);
+        auto x = g->addTensor({1, 3, 16}, DataType::Float32);
+        auto w = g->addTensor({16, 8}, DataType::Float32);
+        auto bias = g->addTensor({8}, DataType::Float32);
+        auto mm = g->addOp<MatmulObj>(x, w, nullptr);
+        auto add = g->addOp<AddObj>(mm->getOutput(), bias, nullptr);
+        auto relu = g->addOp<ReluObj>(add->getOutput(), nullptr);
+        auto out = relu->getOutput();
+        g->dataMalloc();
+        auto gen = [](int seed)
+        {
+            return [seed](void *ptr, size_t size, DataType)
+            {
+                for (size_t i = 0; i < size; ++i)
+                    static_cast<float *>(ptr)[i] =
+                        (float)((i * seed + 3) % 19) - 9.f;
+            };
+        };
+        w->setData(gen(5));
+        bias->setData(gen(7));
+
+        const int nRequests = 11;
+        vector<vector<float>> inputs, expect;
+        for (int r = 0; r < nRequests; ++r)
+        {
+            x->setData(gen(r + 1));
+            runtime->run(g);
+            auto in = x->getRawDataPtr<float *>();
+            auto res = out->getRawDataPtr<float *>();
+            inputs.emplace_back(in, in + x->size());
+            expect.emplace_back(res, res + out->size());
+        }
+
+        DynamicBatcher batcher(g, {x}, 4,
+                               DynamicBatcher::Duration(20000));
+        ASSERT_EQ(batcher.getOutputs(), TensorVec{out});
+        vector<vector<float>> results(nRequests, vector<float>(out->size()));
+        vector<std::future<void>> pending;
+        for (int r = 0; r < nRequests; ++r)
+            pending.emplace_back(
+                batcher.submit({inputs[r].data()}, {results[r].data()}));
+        for (int r = 0; r < nRequests; ++r)
+        {
+            pending[r].get();
+            EXPECT_EQ(results[r], expect[r]);
+        }
+
+        // A single request is served once the wait expires.
+        batcher.setMaxWait(DynamicBatcher::Duration(100));
+        vector<float> single(out->size());
+        batcher.submit({inputs[0].data()}, {single.data()}).get();
+        EXPECT_EQ(single, expect[0]);
+    }
+
+    TEST(DynamicBatcher, RejectsMovedBatchDim)
+    {
+        auto runtime = make_ref<NativeCpuRuntimeObj>();
+        Graph g = make_ref<GraphObj>(runtime);
+        auto x = g->addTensor({1, 3, 4}, DataType::Float32);
+        auto out = g->addOp<TransposeObj>(x, nullptr, vector<int>{1, 0, 2})
+                       ->getOutput();
+        g->dataMalloc();
+
+        // [2, 3, 4] transposes to [3, 2, 4]: the bytes of two requests, but
+        // interleaved, so the batch cannot be split back along dim 0.
+        DynamicBatcher batcher(g, {x}, 2,
+                               DynamicBatcher::Duration(10000000));
+        vector<float> in(x->size()), res0(out->size()), res1(out->size());
+        auto f0 = batcher.submit({in.data()}, {res0.data()});
+        auto f1 = batcher.submit({in.data()}, {res1.data()});
+        EXPECT_THROW(f0.get(), Exception);
+        EXPECT_THROW(f1.get(), Exception);
+    }
+
+} // namespace infini
@@ -51,4 +51,158 @@ namespace infini
         g->dataMalloc();
         EXPECT_EQ(true, true);
     }
-}
\ No newline at end of file
+
+    // Dead intermediates hand their memory on; graph inputs and outputs
+    // keep theirs.
+    TEST(Graph, DataMallocReuse)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor i = g->addTensor({4, 16}, DataType::Float32);
+        auto r1 = g->addOp<TransposeObj>(i, nullptr, Shape{1, 0});
+        auto r2 =
+            g->addOp<TransposeObj>(r1->getOutput(), nullptr, Shape{1, 0});
+        auto r3 =
+            g->addOp<TransposeObj>(r2->getOutput(), nullptr, Shape{1, 0});
+        auto r4 =
+            g->addOp<TransposeObj>(r3->getOutput(), nullptr, Shape{1, 0});
+        g->dataMalloc();
+        auto ptr = [](const Operator &op)
+        { return op->getOutput()->getRawDataPtr<void *>(); };
+        EXPECT_NE(ptr(r1), ptr(r2));
+        EXPECT_EQ(ptr(r1), ptr(r3));
+        EXPECT_EQ(ptr(r2), ptr(r4));
+        for (auto &op : OpVec{r1, r2, r3, r4})
+            EXPECT_NE(ptr(op), i->getRawDataPtr<void *>());
+        // r3 overwrites the output of r1, which r2 reads.
+        EXPECT_TRUE(g->getMemoryDependencies(r1).empty());
+        EXPECT_EQ(g->getMemoryDependencies(r3), (OpVec{r1, r2}));
+
+        i->setData([](void *p, size_t size, DataType)
+                   {
+                       for (size_t k = 0; k < size; ++k)
+                           static_cast<float *>(p)[k] = (float)k - 32.f;
+                   });
+        runtime->run(g);
+        vector<float> expect(64);
+        for (size_t k = 0; k < 64; ++k)
+            expect[k] = (float)k - 32.f;
+        EXPECT_TRUE(r4->getOutput()->equalData(expect));
+    }
+
+    // A transpose feeding only a matmul is a view of its input, and the
+    // matmul reads it through the strides.
+    TEST(Graph, TransposeView)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        auto gen = [](void *ptr, size_t size, DataType)
+        {
+            for (size_t i = 0; i < size; ++i)
+                static_cast<float *>(ptr)[i] = (float)((i * 7) % 11) - 5.f;
+        };
+        for (auto perm : {Shape{0, 2, 1}, Shape{1, 0, 2}, Shape{2, 1, 0}})
+            for (bool transA : {false, true})
+            {
+                // With copy, the transpose is also a graph output, and
+                // dense.
+                vector<float> result[2], transposed;
+                for (bool copy : {true, false})
+                {
+                    Graph g = make_ref<GraphObj>(runtime);
+                    auto a = g->addTensor({4, 6, 5}, DataType::Float32);
+                    auto t = g->addOp<TransposeObj>(a, nullptr, perm);
+                    auto dims = t->getOutput()->getDims();
+                    auto b = g->addTensor({transA ? dims[1] : dims[2], 3},
+                                          DataType::Float32);
+                    auto mm = g->addOp<MatmulObj>(t->getOutput(), b, nullptr,
+                                                  transA);
+                    if (copy)
+                        g->addOp<TransposeObj>(t->getOutput(), nullptr,
+                                               Shape{0, 1, 2});
+                    g->dataMalloc();
+                    EXPECT_EQ(t->getOutput()->isContiguous(), copy);
+                    EXPECT_EQ(t->getOutput()->getRawDataPtr<void *>() ==
+                                  a->getRawDataPtr<void *>(),
+                              !copy);
+                    a->setData(gen);
+                    b->setData(gen);
+                    runtime->run(g);
+                    auto out = mm->getOutput();
+                    auto ptr = out->getRawDataPtr<float *>();
+                    result[copy].assign(ptr, ptr + out->size());
+                    // The view reads through its strides as the copy.
+                    auto view = t->getOutput();
+                    if (copy)
+                    {
+                        auto data = view->getRawDataPtr<float *>();
+                        transposed.assign(data, data + view->size());
+                    }
+                    else
+                    {
+                        EXPECT_TRUE(view->equalData(transposed));
+                        EXPECT_THROW(view->setData(gen), Exception);
+                    }
+                }
+                EXPECT_EQ(result[0], result[1]);
+            }
+    }
+
+    // A matrix between MatMuls gets padded rows, which both of its
+    // consumers read through the strides.
+    TEST(Graph, RowPadding)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        auto gen = [](void *ptr, size_t size, DataType)
+        {
+            for (size_t i = 0; i < size; ++i)
+                static_cast<float *>(ptr)[i] = (float)((i * 5) % 13) - 6.f;
+        };
+        vector<float> result[2][2], hidden;
+        for (size_t rowAlignment : {0, 64})
+        {
+            Graph g = make_ref<GraphObj>(runtime);
+            g->setRowAlignment(rowAlignment);
+            auto x = g->addTensor({2, 5, 7}, DataType::Float32);
+            auto w1 = g->addTensor({7, 13}, DataType::Float32);
+            auto w2 = g->addTensor({13, 3}, DataType::Float32);
+            auto w3 = g->addTensor({2, 4, 5}, DataType::Float32);
+            auto mm1 = g->addOp<MatmulObj>(x, w1, nullptr);
+            auto h = mm1->getOutput();
+            auto mm2 = g->addOp<MatmulObj>(h, w2, nullptr);
+            auto mm3 = g->addOp<MatmulObj>(w3, h, nullptr);
+            g->dataMalloc();
+            const bool padded = rowAlignment > 0;
+            EXPECT_EQ(h->isContiguous(), !padded);
+            if (padded)
+            {
+                EXPECT_EQ(h->getStrides(), (Shape{80, 16, 1}));
+                EXPECT_EQ(h->getStorageBytes(), (80 + 4 * 16 + 13) * 4u);
+                auto ptr = h->getRawDataPtr<void *>();
+                EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr) % 64, 0u);
+            }
+            EXPECT_TRUE(mm2->getOutput()->isContiguous());
+            for (auto &t : {x, w1, w2, w3})
+                t->setData(gen);
+            runtime->run(g);
+            for (int i = 0; i < 2; ++i)
+            {
+                auto out = (i ? mm3 : mm2)->getOutput();
+                auto ptr = out->getRawDataPtr<float *>();
+                result[padded][i].assign(ptr, ptr + out->size());
+            }
+            // The accessors skip the padding.
+            if (!padded)
+            {
+                auto ptr = h->getRawDataPtr<float *>();
+                hidden.assign(ptr, ptr + h->size());
+            }
+            else
+            {
+                EXPECT_TRUE(h->equalData(hidden));
+                EXPECT_THROW(h->setData(gen), Exception);
+            }
+        }
+        EXPECT_EQ(result[0][0], result[1][0]);
+        EXPECT_EQ(result[0][1], result[1][1]);
+    }
+}
@@ -0,0 +1,186 @@
+#include "core/graph.h"
+#include "core/kernel_tuner.h"
+#include "core/plan.h"
+#include "core/runtime.h"
+#include "operators/element_wise.h"
+#include "operators/matmul.h"
+#include "operators/transpose.h"
+#include "operators/unary.h"
+
+#include "test.h"
+#include <cstdio>
+#include <fstream>
+
+namespace infini
+{
+    // Ranked above the real Sub kernels, so that it is the default and
+    // tried first, but computes Int8 only, as a kernel written for fewer
+    // dtypes would.
+    class Int8OnlySub : public CpuKernelWithoutConfig
+    {
+        void compute(const Operator &op,
+                     const RuntimeObj *context) const override
+        {
+            IT_ASSERT(op->getDType() == DataType::Int8,
+                      "Int8OnlySub computes Int8 only");
+            auto a = op->getInputs(0), b = op->getInputs(1);
+            IT_ASSERT(a->size() == b->size());
+            auto pa = a->getRawDataPtr<int8_t *>(),
+                 pb = b->getRawDataPtr<int8_t *>(),
+                 pc = op->getOutput()->getRawDataPtr<int8_t *>();
+            for (size_t i = 0; i < a->size(); ++i)
+                pc[i] = pa[i] - pb[i];
+        }
+    };
+} // namespace infini
+
+REGISTER_KERNEL(Device::CPU, OpType::Sub, Int8OnlySub, "subInt8Only_CPU",
+                100);
+
+namespace infini
+{
+    TEST(KernelRegistry, RankedCandidates)
+    {
+        auto &items = KernelRegistry::getInstance().getKernelItems(
+            KernelAttrs{Device::CPU, OpType::Transpose});
+        ASSERT_EQ(items.size(), 2u);
+        EXPECT_EQ(std::get<1>(items[0]), "TransposeTiled_CPU");
+        EXPECT_EQ(std::get<1>(items[1]), "TransposeNaive_CPU");
+        EXPECT_EQ(KernelRegistry::getInstance().getKernel(
+                      KernelAttrs{Device::CPU, OpType::Transpose}),
+                  std::get<0>(items[0]));
+    }
+
+    TEST(KernelTuner, TuneAndCache)
+    {
+        const string path = "kernel_tuner_test.cache";
+        std::remove(path.c_str());
+        auto &tuner = KernelTuner::getInstance();
+        tuner.clear();
+        tuner.setCacheFile(path);
+
+        auto runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        auto i = g->addTensor({2, 3, 4}, DataType::Float32);
+        auto op = g->addOp<TransposeObj>(i, nullptr, Shape{2, 0, 1});
+        auto i8 = g->addTensor({2, 3, 4}, DataType::Int8);
+        auto op8 = g->addOp<TransposeObj>(i8, nullptr, Shape{2, 0, 1});
+        g->dataMalloc();
+        i->setData(IncrementalGenerator());
+
+        runtime->setAutotune(true);
+        runtime->run(g);
+        runtime->setAutotune(false);
+        EXPECT_TRUE(op->getOutput()->equalData(
+            vector<float>{0, 4, 8, 12, 16, 20, 1, 5, 9, 13, 17, 21,
+                          2, 6, 10, 14, 18, 22, 3, 7, 11, 15, 19, 23}));
+        auto decision = tuner.getDecision(op);
+        ASSERT_TRUE(decision.has_value());
+        auto decision8 = tuner.getDecision(op8);
+        ASSERT_TRUE(decision8.has_value());
+
+        // A fresh tuner state reloads the decisions from the cache file.
+        tuner.clear();
+        EXPECT_FALSE(tuner.getDecision(op).has_value());
+        tuner.setCacheFile(path);
+        EXPECT_EQ(tuner.getDecision(op), decision);
+        EXPECT_EQ(tuner.getDecision(op8), decision8);
+
+        // Stale entries naming unknown kernels are re-tuned.
+        std::ofstream(path, std::ios::app)
+            << KernelTuner::getKey(op) << "\tTransposeGone_CPU\n";
+        tuner.clear();
+        tuner.setCacheFile(path);
+        tuner.getKernel(op, runtime.get());
+        EXPECT_NE(tuner.getDecision(op), "TransposeGone_CPU");
+
+        tuner.setCacheFile("");
+        tuner.clear();
+        std::remove(path.c_str());
+    }
+
+    // A candidate throwing an Exception for the op is skipped.
+    TEST(KernelTuner, SkipsUnsupported)
+    {
+        auto &tuner = KernelTuner::getInstance();
+        tuner.clear();
+        auto runtime = make_ref<NativeCpuRuntimeObj>();
+        Graph g = make_ref<GraphObj>(runtime);
+        auto a = g->addTensor({2, 3}, DataType::Float32);
+        auto b = g->addTensor({2, 3}, DataType::Float32);
+        auto sub = g->addOp<SubObj>(a, b, nullptr);
+        g->dataMalloc();
+        a->setData(IncrementalGenerator());
+        b->setData(OneGenerator());
+        // The default candidate rejects Float32.
+        EXPECT_THROW(runtime->run(g), Exception);
+
+        runtime->setAutotune(true);
+        runtime->run(g);
+        runtime->setAutotune(false);
+        auto decision = tuner.getDecision(sub);
+        ASSERT_TRUE(decision.has_value());
+        EXPECT_NE(decision, "subInt8Only_CPU");
+        EXPECT_TRUE(sub->getOutput()->equalData(
+            vector<float>{-1, 0, 1, 2, 3, 4}));
+        tuner.clear();
+    }
+
+    // Tuning an op computed in place over its input runs the candidates
+    // on copies, so the results do not compound.
+    TEST(KernelTuner, InPlace)
+    {
+        auto &tuner = KernelTuner::getInstance();
+        tuner.clear();
+        auto runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        auto a = g->addTensor({4, 5}, DataType::Float32);
+        auto b = g->addTensor({4, 5}, DataType::Float32);
+        auto relu = g->addOp<ReluObj>(a, nullptr);
+        auto add = g->addOp<AddObj>(relu->getOutput(), b, nullptr);
+        g->dataMalloc();
+        ASSERT_EQ(add->getOutput()->getRawDataPtr<void *>(),
+                  relu->getOutput()->getRawDataPtr<void *>());
+        a->setData(OneGenerator());
+        b->setData(OneGenerator());
+
+        runtime->setAutotune(true);
+        runtime->run(g);
+        runtime->setAutotune(false);
+        EXPECT_TRUE(add->getOutput()->equalData(vector<float>(20, 2.f)));
+        EXPECT_TRUE(a->equalData(vector<float>(20, 1.f)));
+        tuner.clear();
+    }
+
+    // A transpose made a view is never run, so tuning cannot pick a
+    // kernel that permutes the shared data in place.
+    TEST(KernelTuner, TransposeView)
+    {
+        auto &tuner = KernelTuner::getInstance();
+        tuner.clear();
+        auto runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        auto a = g->addTensor({3, 5}, DataType::Float32);
+        auto b = g->addTensor({3, 1}, DataType::Float32);
+        auto t = g->addOp<TransposeObj>(a, nullptr, Shape{1, 0});
+        auto mm = g->addOp<MatmulObj>(t->getOutput(), b, nullptr);
+        g->dataMalloc();
+        ASSERT_TRUE(g->isView(t));
+        a->setData(IncrementalGenerator());
+        b->setData(OneGenerator());
+
+        runtime->setAutotune(true);
+        runtime->run(g);
+        auto plan = runtime->compile(g);
+        runtime->setAutotune(false);
+        EXPECT_EQ(plan->size(), 1u);
+        runtime->run(plan);
+        EXPECT_FALSE(tuner.getDecision(t).has_value());
+        EXPECT_TRUE(a->equalData(vector<float>{0, 1, 2, 3, 4, 5, 6, 7, 8,
+                                               9, 10, 11, 12, 13, 14}));
+        EXPECT_TRUE(mm->getOutput()->equalData(
+            vector<float>{15, 18, 21, 24, 27}));
+        tuner.clear();
+    }
+
+} // namespace infini
@@ -0,0 +1,134 @@
+#include "core/graph.h"
+#include "core/memory_planner.h"
+#include "core/runtime.h"
+#include "operators/element_wise.h"
+#include "operators/unary.h"
+
+#include "test.h"
+
+namespace infini
+{
+    using Strategy = MemoryPlanner::Strategy;
+
+    static void expectValid(const vector<MemoryPlanner::Interval> &intervals,
+                            const MemoryPlanner::Plan &plan)
+    {
+        ASSERT_EQ(plan.offsets.size(), intervals.size());
+        EXPECT_GE(plan.arena, plan.lowerBound);
+        for (size_t i = 0; i < intervals.size(); ++i)
+        {
+            EXPECT_EQ(plan.offsets[i] % 8, 0u);
+            EXPECT_LE(plan.offsets[i] + intervals[i].size, plan.arena);
+            for (size_t j = 0; j < i; ++j)
+            {
+                const auto &a = intervals[i], &b = intervals[j];
+                if (a.begin > b.end || b.begin > a.end)
+                    continue;
+                EXPECT_TRUE(plan.offsets[i] + a.size <= plan.offsets[j] ||
+                            plan.offsets[j] + b.size <= plan.offsets[i]);
+            }
+        }
+    }
+
+    TEST(MemoryPlanner, Strategies)
+    {
+        vector<MemoryPlanner::Interval> intervals{
+            {0, 1, 32}, {1, 2, 64}, {2, 3, 32}, {3, 4, 64},
+            {0, 4, 13}, {1, 3, 8},  {4, 5, 96}, {2, 5, 24},
+        };
+        EXPECT_EQ(MemoryPlanner::lowerBound(intervals, 8), 200u);
+        for (auto strategy : {Strategy::GreedyBySize,
+                              Strategy::GreedyByBreadth,
+                              Strategy::IntervalColoring})
+        {
+            auto plan = MemoryPlanner::plan(intervals, 8, strategy);
+            EXPECT_EQ(plan.strategy, strategy);
+            expectValid(intervals, plan);
+        }
+        auto best = MemoryPlanner::plan(intervals, 8);
+        expectValid(intervals, best);
+        for (auto strategy : {Strategy::GreedyBySize,
+                              Strategy::GreedyByBreadth,
+                              Strategy::IntervalColoring})
+            EXPECT_LE(best.arena,
+                      MemoryPlanner::plan(intervals, 8, strategy).arena);
+    }
+
+    TEST(MemoryPlanner, Alias)
+    {
+        // 1 is computed over 0, and 2 over 1; 3 finds 1 already taken.
+        vector<MemoryPlanner::Interval> intervals{
+            {0, 1, 64}, {1, 2, 64, 0}, {2, 3, 32, 1}, {2, 4, 64, 1}};
+        auto plan = MemoryPlanner::plan(intervals, 8);
+        EXPECT_EQ(plan.offsets[0], plan.offsets[1]);
+        EXPECT_EQ(plan.offsets[1], plan.offsets[2]);
+        EXPECT_NE(plan.offsets[2], plan.offsets[3]);
+        EXPECT_EQ(plan.lowerBound, 128u);
+        EXPECT_EQ(plan.arena, 128u);
+    }
+
+    TEST(MemoryPlanner, Alignment)
+    {
+        vector<MemoryPlanner::Interval> intervals{
+            {0, 2, 40}, {1, 2, 24, -1, 256}, {0, 1, 8}};
+        auto plan = MemoryPlanner::plan(intervals, 64);
+        expectValid(intervals, plan);
+        for (auto offset : plan.offsets)
+            EXPECT_EQ(offset % 64, 0u);
+        EXPECT_EQ(plan.offsets[1] % 256, 0u);
+        EXPECT_EQ(plan.lowerBound, 192u);
+
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor a = g->addTensor({3, 5}, DataType::Float32);
+        Tensor w = g->addTensor({5, 7}, DataType::Float32);
+        auto add = g->addOp<AddObj>(a, a, nullptr);
+        auto mul = g->addOp<MulObj>(w, w, nullptr);
+        g->setAlignment(w, 4096);
+        EXPECT_THROW(g->setAlignment(a, 48), Exception);
+        g->dataMalloc();
+        auto address = [](const Tensor &t)
+        { return reinterpret_cast<uintptr_t>(t->getRawDataPtr<void *>()); };
+        for (auto &t : g->getTensors())
+            EXPECT_EQ(address(t) % 64, 0u);
+        EXPECT_EQ(address(w) % 4096, 0u);
+    }
+
+    // A chain reaches the lower bound, and dataMalloc uses the plan with
+    // element-wise ops computed in place.
+    TEST(MemoryPlanner, Graph)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor i = g->addTensor({8, 16}, DataType::Float32);
+        auto r1 = g->addOp<ReluObj>(i, nullptr);
+        auto r2 = g->addOp<ReluObj>(r1->getOutput(), nullptr);
+        auto add = g->addOp<AddObj>(r2->getOutput(), i, nullptr);
+        auto r3 = g->addOp<ReluObj>(add->getOutput(), nullptr);
+        g->dataMalloc();
+        const auto &plan = g->getMemoryPlan();
+        EXPECT_EQ(plan.arena, plan.lowerBound);
+        EXPECT_EQ(plan.lowerBound, 2 * i->getBytes());
+        auto ptr = [](const Operator &op)
+        { return op->getOutput()->getRawDataPtr<void *>(); };
+        EXPECT_EQ(ptr(r1), ptr(r2));
+        EXPECT_EQ(ptr(r2), ptr(add));
+        EXPECT_EQ(ptr(add), ptr(r3));
+        EXPECT_NE(ptr(r1), i->getRawDataPtr<void *>());
+
+        i->setData([](void *p, size_t size, DataType)
+                   {
+                       for (size_t k = 0; k < size; ++k)
+                           static_cast<float *>(p)[k] = (float)k - 64.f;
+                   });
+        runtime->run(g);
+        vector<float> expect(i->size());
+        for (size_t k = 0; k < expect.size(); ++k)
+        {
+            float x = (float)k - 64.f;
+            expect[k] = std::max(std::max(x, 0.f) + x, 0.f);
+        }
+        EXPECT_TRUE(r3->getOutput()->equalData(expect));
+    }
+
+} // namespace infini
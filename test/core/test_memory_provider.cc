@@ -0,0 +1,76 @@
+#include "core/graph.h"
+#include "core/memory_provider.h"
+#include "core/runtime.h"
+
+#include "test.h"
+#include <cstring>
+#include <fstream>
+
+namespace infini
+{
+    TEST(MemoryProvider, Alignment)
+    {
+        MemoryProvider provider;
+        EXPECT_THROW(provider.setAlignment(48), Exception);
+        for (size_t align : {64, 256, 4096})
+        {
+            provider.setAlignment(align);
+            for (size_t size : {1, 100, 5000})
+            {
+                void *ptr = provider.alloc(size);
+                EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr) % align, 0u);
+                EXPECT_EQ(provider.getPageMode(ptr), HugePages::None);
+                std::memset(ptr, 1, size);
+                provider.dealloc(ptr);
+            }
+        }
+        int x;
+        EXPECT_THROW(provider.dealloc(&x), Exception);
+    }
+
+    TEST(MemoryProvider, HugePages)
+    {
+        MemoryProvider provider;
+        const size_t size = 3 * MemoryProvider::HUGE_PAGE + 5;
+        for (auto mode : {HugePages::Transparent, HugePages::Explicit})
+        {
+            provider.setHugePages(mode);
+            void *ptr = provider.alloc(size);
+            // Explicit falls back to transparent without a huge page pool.
+            auto got = provider.getPageMode(ptr);
+            EXPECT_TRUE(got == mode || got < mode);
+            // With transparent huge pages disabled, madvise() succeeds but
+            // the block keeps regular pages.
+            string thp;
+            std::getline(
+                std::ifstream("/sys/kernel/mm/transparent_hugepage/enabled"),
+                thp);
+            if (thp.find("[never]") != string::npos)
+            {
+                EXPECT_NE(got, HugePages::Transparent);
+            }
+            if (got != HugePages::None)
+            {
+                EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr) %
+                              MemoryProvider::HUGE_PAGE,
+                          0u);
+            }
+            std::memset(ptr, 1, size);
+            provider.dealloc(ptr);
+            // Small blocks keep using the heap.
+            ptr = provider.alloc(4096);
+            EXPECT_EQ(provider.getPageMode(ptr), HugePages::None);
+            provider.dealloc(ptr);
+        }
+    }
+
+    TEST(MemoryProvider, Runtime)
+    {
+        auto runtime = make_ref<NativeCpuRuntimeObj>();
+        runtime->getMemoryProvider().setAlignment(128);
+        void *ptr = runtime->alloc(1000);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr) % 128, 0u);
+        runtime->dealloc(ptr);
+    }
+
+} // namespace infini
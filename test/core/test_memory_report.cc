@@ -0,0 +1,101 @@
+#include "core/graph.h"
+#include "core/memory_report.h"
+#include "core/runtime.h"
+#include "operators/matmul.h"
+#include "operators/transpose.h"
+#include "operators/unary.h"
+
+#include "test.h"
+#include <sstream>
+
+namespace infini
+{
+    TEST(MemoryReport, Steps)
+    {
+        // b is computed in place over a at step 1.
+        MemoryReport report({{1, 0, 64, 0, 1, ""},
+                             {2, 0, 64, 1, 2, "Relu#5"},
+                             {3, 64, 128, 0, 2, ""}},
+                            {"Relu#4", "Relu#5", "Relu#6"}, 192, 192);
+        ASSERT_EQ(report.getSteps().size(), 3u);
+        EXPECT_EQ(report.getSteps()[1].live, 192u);
+        EXPECT_EQ(report.getSteps()[1].extent, 192u);
+        EXPECT_EQ(report.getPeakStep(), 0u);
+        auto peak = report.getPeakAllocations();
+        ASSERT_EQ(peak.size(), 2u);
+        EXPECT_EQ(peak[0].fuid, 3);
+        EXPECT_DOUBLE_EQ(report.getFragmentation(), 0.);
+
+        std::ostringstream csv;
+        report.dumpCsv(csv);
+        EXPECT_EQ(csv.str(), "fuid,offset,size,begin,end,producer\n"
+                             "1,0,64,0,1,\n"
+                             "2,0,64,1,2,Relu#5\n"
+                             "3,64,128,0,2,\n");
+        std::ostringstream curve;
+        report.dumpUtilizationCsv(curve);
+        EXPECT_EQ(curve.str(), "step,op,live,extent\n"
+                               "0,Relu#4,192,192\n"
+                               "1,Relu#5,192,192\n"
+                               "2,Relu#6,192,192\n");
+        auto map = report.renderAscii(6);
+        EXPECT_NE(map.find("*   0 |AACCCC| Relu#4"), string::npos);
+        EXPECT_NE(map.find("    2 |BBCCCC| Relu#6"), string::npos);
+    }
+
+    // The report of dataMalloc() attributes the peak to the matmul.
+    TEST(MemoryReport, Graph)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        auto a = g->addTensor({16, 32}, DataType::Float32);
+        auto b = g->addTensor({32, 64}, DataType::Float32);
+        auto t = g->addOp<TransposeObj>(a, nullptr, Shape{1, 0});
+        auto mm = g->addOp<MatmulObj>(t->getOutput(), b, nullptr, true);
+        auto relu = g->addOp<ReluObj>(mm->getOutput(), nullptr);
+        g->dataMalloc();
+        const auto &report = g->getMemoryReport();
+        EXPECT_EQ(report.getArena(), g->getMemoryPlan().arena);
+        // The transpose is a view of a, with no memory of its own.
+        EXPECT_EQ(report.getAllocations().size(), g->getTensors().size() - 1);
+        const size_t peak = report.getPeakStep();
+        EXPECT_EQ(report.getSteps()[peak].op,
+                  "MatMul#" + std::to_string(mm->getGuid()));
+        auto live = report.getPeakAllocations();
+        EXPECT_EQ(live[0].fuid, b->getFuid());
+        const auto fuid = mm->getOutput()->getFuid();
+        EXPECT_TRUE(std::any_of(live.begin(), live.end(), [&](auto &x)
+                                { return x.fuid == fuid; }));
+        EXPECT_GE(report.getFragmentation(), 0.);
+        auto summary = report.summary();
+        EXPECT_EQ(summary.find("Memory: arena " +
+                               std::to_string(report.getArena()) + " bytes"),
+                  0u);
+        EXPECT_NE(summary.find("(MatMul#" + std::to_string(mm->getGuid()) +
+                               ")"),
+                  string::npos);
+        auto map = report.renderAscii();
+        // The peak row is starred and names the matmul.
+        const auto star = map.find('*');
+        ASSERT_NE(star, string::npos);
+        EXPECT_NE(map.substr(star, map.find('\n', star) - star)
+                      .find("| MatMul#" + std::to_string(mm->getGuid())),
+                  string::npos);
+
+        std::ostringstream json, svg;
+        const auto flags = json.flags();
+        const auto precision = json.precision();
+        report.dumpJson(json);
+        EXPECT_EQ(json.flags(), flags);
+        EXPECT_EQ(json.precision(), precision);
+        EXPECT_NE(json.str().find("\"lower_bound\": " +
+                                  std::to_string(report.getLowerBound())),
+                  string::npos);
+        EXPECT_NE(json.str().find("\"producer\": \"Relu#" +
+                                  std::to_string(relu->getGuid())),
+                  string::npos);
+        report.renderSvg(svg);
+        EXPECT_EQ(svg.str().rfind("</svg>\n"), svg.str().size() - 7);
+    }
+
+} // namespace infini
@@ -0,0 +1,69 @@
+#include "core/graph.h"
+#include "core/kernel_tuner.h"
+#include "core/plan.h"
+#include "core/profiler.h"
+#include "core/runtime.h"
+#include "operators/element_wise.h"
+#include "operators/matmul.h"
+#include "operators/unary.h"
+
+#include "test.h"
+#include <sstream>
+
+namespace infini
+{
+    TEST(Profiler, RecordsAndExports)
+    {
+        auto runtime = make_ref<NativeCpuRuntimeObj>();
+        Graph g = make_ref<GraphObj>(runtime);
+        auto a = g->addTensor({2, 8, 16}, DataType::Float32);
+        auto b = g->addTensor({16, 4}, DataType::Float32);
+        auto mm = g->addOp<MatmulObj>(a, b, nullptr);
+        auto relu = g->addOp<ReluObj>(mm->getOutput(), nullptr);
+        auto add = g->addOp<AddObj>(relu->getOutput(), relu->getOutput(),
+                                    nullptr);
+        g->dataMalloc();
+
+        EXPECT_THROW(runtime->getProfiler(), Exception);
+        runtime->setProfiling(true);
+        runtime->run(g);
+        runtime->run(runtime->compile(g));
+        runtime->setProfiling(false);
+        runtime->run(g);
+
+        auto &profiler = runtime->getProfiler();
+        auto records = profiler.getRecords();
+        ASSERT_EQ(records.size(), 6u);
+        EXPECT_EQ(records[0].name, "MatMul");
+        EXPECT_EQ(records[0].key, KernelTuner::getKey(mm));
+        EXPECT_EQ(records[0].flops, 2u * 2 * 8 * 4 * 16);
+        EXPECT_EQ(records[0].bytesRead, (2u * 8 * 16 + 16 * 4) * 4);
+        EXPECT_EQ(records[0].bytesWritten, 2u * 8 * 4 * 4);
+        EXPECT_EQ(records[2].flops, 2u * 8 * 4);
+        for (size_t i = 0; i < records.size(); ++i)
+        {
+            EXPECT_EQ(records[i].thread, 0);
+            EXPECT_GE(records[i].duration, 0);
+            if (i > 0)
+            {
+                EXPECT_GE(records[i].start, records[i - 1].start);
+            }
+        }
+
+        std::ostringstream trace;
+        const auto flags = trace.flags();
+        const auto precision = trace.precision();
+        profiler.dumpChromeTrace(trace);
+        EXPECT_EQ(trace.flags(), flags);
+        EXPECT_EQ(trace.precision(), precision);
+        EXPECT_NE(trace.str().find("\"traceEvents\""), string::npos);
+        EXPECT_NE(trace.str().find("\"ph\": \"X\""), string::npos);
+        auto summary = profiler.summary();
+        EXPECT_NE(summary.find(KernelTuner::getKey(add)), string::npos);
+        EXPECT_NE(summary.find("in 6 ops"), string::npos);
+
+        profiler.clear();
+        EXPECT_TRUE(profiler.getRecords().empty());
+    }
+
+} // namespace infini
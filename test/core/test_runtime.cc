@@ -0,0 +1,472 @@
+#include "core/graph.h"
+#include "core/kernel_tuner.h"
+#include "core/numa.h"
+#include "core/plan.h"
+#include "core/runtime.h"
+#include "core/thread_pool.h"
+#include "operators/concat.h"
+#include "operators/element_wise.h"
+#include "operators/matmul.h"
+#include "operators/transpose.h"
+#include "operators/unary.h"
+
+#include "test.h"
+#include <cstdio>
+#include <fstream>
+#include <thread>
+#ifdef __linux__
+#include <sched.h>
+#endif
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace infini
+{
+    TEST(Runtime, ThreadPolicy)
+    {
+        auto runtime = make_ref<NativeCpuRuntimeObj>();
+        runtime->setNumThreads(4);
+        runtime->setGrainSize(1000);
+        EXPECT_EQ(runtime->getNumThreads(), 4);
+        EXPECT_EQ(runtime->getTaskThreads(0), 1);
+        EXPECT_EQ(runtime->getTaskThreads(1999), 1);
+        EXPECT_EQ(runtime->getTaskThreads(3000), 3);
+        EXPECT_EQ(runtime->getTaskThreads(1 << 20), 4);
+        runtime->setNumThreads(0);
+        EXPECT_GE(runtime->getNumThreads(), 1);
+    }
+
+    // Every kernel gives the same result however the policy splits it.
+    TEST(Runtime, ThreadPolicyKernels)
+    {
+        auto runtime = make_ref<NativeCpuRuntimeObj>();
+        Graph g = make_ref<GraphObj>(runtime);
+        auto a = g->addTensor({3, 67, 45}, DataType::Float32);
+        auto b = g->addTensor({67, 1}, DataType::Float32);
+        auto c = g->addTensor({3, 45, 29}, DataType::Float32);
+        auto add = g->addOp<AddObj>(a, b, nullptr);
+        auto mul = g->addOp<MulObj>(a, a, nullptr);
+        auto relu = g->addOp<ReluObj>(add->getOutput(), nullptr);
+        auto trans = g->addOp<TransposeObj>(a, nullptr, Shape{2, 0, 1});
+        auto concat = g->addOp<ConcatObj>(TensorVec{a, mul->getOutput()},
+                                          nullptr, 1);
+        auto matmul = g->addOp<MatmulObj>(a, c, nullptr);
+        g->dataMalloc();
+        auto gen = [](void *ptr, size_t size, DataType)
+        {
+            for (size_t i = 0; i < size; ++i)
+                static_cast<float *>(ptr)[i] = (float)((i * 7) % 13) - 6.f;
+        };
+        a->setData(gen);
+        b->setData(gen);
+        c->setData(gen);
+
+        OpVec ops{add, mul, relu, trans, concat, matmul};
+        runtime->setNumThreads(1);
+        runtime->run(g);
+        vector<vector<float>> expect;
+        for (auto &op : ops)
+        {
+            auto out = op->getOutput();
+            auto ptr = out->getRawDataPtr<float *>();
+            expect.emplace_back(ptr, ptr + out->size());
+        }
+
+        runtime->setNumThreads(4);
+        runtime->setGrainSize(64);
+        runtime->run(g);
+        size_t i = 0;
+        for (auto &op : ops)
+            EXPECT_TRUE(op->getOutput()->equalData(expect[i++]));
+    }
+
+    TEST(Runtime, InterOpParallel)
+    {
+        auto runtime = make_ref<NativeCpuRuntimeObj>();
+        Graph g = make_ref<GraphObj>(runtime);
+        // Two transposed inputs of a matmul plus an independent branch.
+        auto a = g->addTensor({4, 32, 48}, DataType::Float32);
+        auto b = g->addTensor({4, 40, 32}, DataType::Float32);
+        auto ta = g->addOp<TransposeObj>(a, nullptr, Shape{0, 2, 1});
+        auto tb = g->addOp<TransposeObj>(b, nullptr, Shape{0, 2, 1});
+        auto mm = g->addOp<MatmulObj>(ta->getOutput(), tb->getOutput(),
+                                      nullptr);
+        auto relu = g->addOp<ReluObj>(mm->getOutput(), nullptr);
+        auto add = g->addOp<AddObj>(a, a, nullptr);
+        auto mul = g->addOp<MulObj>(add->getOutput(), add->getOutput(),
+                                    nullptr);
+        g->dataMalloc();
+        auto gen = [](void *ptr, size_t size, DataType)
+        {
+            for (size_t i = 0; i < size; ++i)
+                static_cast<float *>(ptr)[i] = (float)((i * 5) % 11) - 5.f;
+        };
+        a->setData(gen);
+        b->setData(gen);
+
+        OpVec ops{ta, tb, mm, relu, add, mul};
+        runtime->run(g);
+        // Intermediates may share memory, so take every snapshot first.
+        vector<vector<float>> expect;
+        for (auto &op : ops)
+        {
+            auto out = op->getOutput();
+            auto ptr = out->getRawDataPtr<float *>();
+            expect.emplace_back(ptr, ptr + out->size());
+        }
+        // The transposes feeding the matmul are views of the inputs.
+        EXPECT_FALSE(ta->getOutput()->isContiguous());
+        for (auto &op : ops)
+        {
+            if (!op->getOutput()->isContiguous())
+                continue;
+            auto ptr = op->getOutput()->getRawDataPtr<float *>();
+            std::fill(ptr, ptr + op->getOutput()->size(), 0.f);
+        }
+
+        runtime->setInterOpThreads(4);
+        for (int iter = 0; iter < 10; ++iter)
+        {
+            runtime->run(g);
+            // The views are left out: their snapshot holds the layout of
+            // the inputs, which no op writes.
+            for (size_t i = 0; i < ops.size(); ++i)
+                if (ops[i]->getOutput()->isContiguous())
+                {
+                    EXPECT_TRUE(ops[i]->getOutput()->equalData(expect[i]));
+                }
+        }
+
+        // Kernel errors are rethrown by run().
+        Graph bad = make_ref<GraphObj>(runtime);
+        auto x = bad->addTensor({2, 2}, DataType::Int32);
+        bad->addOp<MatmulObj>(x, x, nullptr);
+        bad->addOp<AddObj>(x, x, nullptr);
+        bad->dataMalloc();
+        EXPECT_THROW(runtime->run(bad), Exception);
+        runtime->setInterOpThreads(1);
+    }
+
+    // A compiled plan computes what run(graph) does, also on new input data.
+    TEST(Runtime, ExecutionPlan)
+    {
+        auto runtime = make_ref<NativeCpuRuntimeObj>();
+        Graph g = make_ref<GraphObj>(runtime);
+        auto a = g->addTensor({2, 17, 24}, DataType::Float32);
+        auto b = g->addTensor({17, 1}, DataType::Float32);
+        auto c = g->addTensor({2, 48, 9}, DataType::Float32);
+        auto add = g->addOp<AddObj>(a, b, nullptr);
+        auto clip = g->addOp<ClipObj>(add->getOutput(), nullptr, -2.f, 3.f);
+        auto trans = g->addOp<TransposeObj>(clip->getOutput(), nullptr,
+                                            Shape{2, 0, 1});
+        auto concat = g->addOp<ConcatObj>(TensorVec{a, add->getOutput()},
+                                          nullptr, 2);
+        auto matmul = g->addOp<MatmulObj>(concat->getOutput(), c, nullptr,
+                                          false, false);
+        auto cast = g->addOp<CastObj>(matmul->getOutput(), nullptr,
+                                      CastType::Float2Int32);
+        g->dataMalloc();
+
+        OpVec ops{add, clip, trans, concat, matmul};
+        auto plan = runtime->compile(g);
+        EXPECT_EQ(plan->size(), g->getOperators().size());
+        for (int seed : {3, 7})
+        {
+            auto gen = [seed](void *ptr, size_t size, DataType)
+            {
+                for (size_t i = 0; i < size; ++i)
+                    static_cast<float *>(ptr)[i] =
+                        (float)((i * seed) % 13) - 6.f;
+            };
+            a->setData(gen);
+            b->setData(gen);
+            c->setData(gen);
+            runtime->run(g);
+            vector<vector<float>> expect;
+            for (auto &op : ops)
+            {
+                auto out = op->getOutput();
+                auto ptr = out->getRawDataPtr<float *>();
+                expect.emplace_back(ptr, ptr + out->size());
+            }
+            auto castOut = cast->getOutput()->getRawDataPtr<int32_t *>();
+            vector<int32_t> expectCast(castOut,
+                                       castOut + cast->getOutput()->size());
+            for (auto &op : ops)
+            {
+                auto ptr = op->getOutput()->getRawDataPtr<float *>();
+                std::fill(ptr, ptr + op->getOutput()->size(), 0.f);
+            }
+
+            for (int iter = 0; iter < 2; ++iter)
+            {
+                runtime->run(plan);
+                for (size_t i = 0; i < ops.size(); ++i)
+                    EXPECT_TRUE(ops[i]->getOutput()->equalData(expect[i]));
+                EXPECT_TRUE(cast->getOutput()->equalData(expectCast));
+            }
+        }
+    }
+
+    // Plans with their own memory run concurrently on separate data.
+    TEST(Runtime, AsyncRun)
+    {
+        auto runtime = make_ref<NativeCpuRuntimeObj>();
+        Graph g = make_ref<GraphObj>(runtime);
+        auto a = g->addTensor({4, 16, 32}, DataType::Float32);
+        auto b = g->addTensor({32, 8}, DataType::Float32);
+        auto mm = g->addOp<MatmulObj>(a, b, nullptr);
+        auto relu = g->addOp<ReluObj>(mm->getOutput(), nullptr);
+        auto out = relu->getOutput();
+        g->setExternal(a);
+        g->dataMalloc();
+        auto gen = [](int seed)
+        {
+            return [seed](void *ptr, size_t size, DataType)
+            {
+                for (size_t i = 0; i < size; ++i)
+                    static_cast<float *>(ptr)[i] =
+                        (float)((i * seed) % 17) - 8.f;
+            };
+        };
+
+        // The weight b is set on the graph only and shared by the plans;
+        // each request binds its own input a.
+        b->setData(gen(2));
+        const int nRequests = 4;
+        vector<vector<float>> inputs, expect;
+        for (int r = 0; r < nRequests; ++r)
+        {
+            inputs.emplace_back(a->size());
+            gen(r + 1)(inputs[r].data(), a->size(), DataType::Float32);
+            g->bindExternal(a, inputs[r].data());
+            runtime->run(g);
+            auto ptr = out->getRawDataPtr<float *>();
+            expect.emplace_back(ptr, ptr + out->size());
+        }
+
+        auto graphData = out->getRawDataPtr<void *>();
+        vector<ExecutionPlan> plans;
+        for (int r = 0; r < nRequests; ++r)
+        {
+            plans.emplace_back(runtime->compile(g, true));
+            EXPECT_TRUE(plans.back()->hasOwnMemory());
+            EXPECT_NE(plans.back()->getData<void *>(out), graphData);
+            EXPECT_NE(plans.back()->getData<void *>(mm->getOutput()),
+                      mm->getOutput()->getRawDataPtr<void *>());
+            EXPECT_EQ(plans.back()->getData<void *>(b),
+                      b->getRawDataPtr<void *>());
+            plans.back()->bind(a, inputs[r].data());
+        }
+        EXPECT_EQ(out->getRawDataPtr<void *>(), graphData);
+
+        runtime->setAsyncThreads(2);
+        for (int iter = 0; iter < 3; ++iter)
+        {
+            vector<std::future<void>> pending;
+            for (int r = 0; r < nRequests; ++r)
+                pending.emplace_back(runtime->runAsync(plans[r]));
+            for (int r = 0; r < nRequests; ++r)
+            {
+                pending[r].get();
+                auto ptr = plans[r]->getData<float *>(out);
+                EXPECT_EQ(vector<float>(ptr, ptr + out->size()), expect[r]);
+            }
+        }
+    }
+
+    // Kernels without a prepared path, here picked from the tuner's cache,
+    // also run on a plan's own memory.
+    TEST(Runtime, AsyncRunUnprepared)
+    {
+        auto runtime = make_ref<NativeCpuRuntimeObj>();
+        Graph g = make_ref<GraphObj>(runtime);
+        auto a = g->addTensor({3, 4}, DataType::Float32);
+        auto b = g->addTensor({3, 2}, DataType::Float32);
+        auto concat = g->addOp<ConcatObj>(TensorVec{a, b}, nullptr, 1);
+        auto out = concat->getOutput();
+        g->dataMalloc();
+        a->setData(ZeroGenerator());
+        b->setData(ZeroGenerator());
+        out->setData(ZeroGenerator());
+
+        const string path = "runtime_unprepared_test.cache";
+        std::ofstream(path) << KernelTuner::getKey(concat)
+                            << "\tConcatNaive_CPU\n";
+        auto &tuner = KernelTuner::getInstance();
+        tuner.clear();
+        tuner.setCacheFile(path);
+        runtime->setAutotune(true);
+        auto plan = runtime->compile(g, true);
+        runtime->setAutotune(false);
+        EXPECT_EQ(plan->getEntries()[0].params, nullptr);
+
+        a->setData(ValGenerator<7>());
+        b->setData(ValGenerator<7>());
+        runtime->runAsync(plan).get();
+        auto ptr = plan->getData<float *>(out);
+        EXPECT_EQ(vector<float>(ptr, ptr + out->size()),
+                  vector<float>(out->size(), 7.f));
+        EXPECT_TRUE(out->equalData(vector<float>(out->size(), 0.f)));
+
+        tuner.setCacheFile("");
+        tuner.clear();
+        std::remove(path.c_str());
+    }
+
+    TEST(Runtime, ExternalBuffers)
+    {
+        auto runtime = make_ref<NativeCpuRuntimeObj>();
+        Graph g = make_ref<GraphObj>(runtime);
+        auto a = g->addTensor({5, 33}, DataType::Float32);
+        auto b = g->addTensor({33}, DataType::Float32);
+        auto add = g->addOp<AddObj>(a, b, nullptr);
+        auto relu = g->addOp<ReluObj>(add->getOutput(), nullptr);
+        auto out = relu->getOutput();
+        EXPECT_THROW(g->setExternal(add->getOutput()), Exception);
+        g->setExternal(a);
+        g->setExternal(out);
+        g->dataMalloc();
+        EXPECT_FALSE(a->getDataBlob());
+        EXPECT_TRUE(b->getDataBlob());
+        b->setData(IncrementalGenerator());
+
+        auto expect = [&](const vector<float> &in)
+        {
+            vector<float> res(in.size());
+            for (size_t i = 0; i < in.size(); ++i)
+                res[i] = std::max(0.f, in[i] + (float)(i % 33));
+            return res;
+        };
+        vector<float> in0(a->size()), in1(a->size()), res0(out->size()),
+            res1(out->size());
+        for (size_t i = 0; i < in0.size(); ++i)
+        {
+            in0[i] = (float)(i % 7) - 20.f;
+            in1[i] = (float)(i % 11) - 3.f;
+        }
+
+        // The graph reads and writes the caller's buffers directly.
+        EXPECT_THROW(g->bindExternal(a, (uint8_t *)in0.data() + 1), Exception);
+        g->bindExternal(a, in0.data());
+        g->bindExternal(out, res0.data());
+        runtime->run(g);
+        EXPECT_EQ(res0, expect(in0));
+
+        // Plans keep their own bindings and re-prepare the affected ops.
+        for (bool ownMemory : {false, true})
+        {
+            auto plan = runtime->compile(g, ownMemory);
+            EXPECT_EQ(plan->getData<float *>(a), in0.data());
+            plan->bind(a, in1.data());
+            plan->bind(out, res1.data());
+            runtime->run(plan);
+            EXPECT_EQ(res1, expect(in1));
+            plan->bind(a, in0.data());
+            runtime->run(plan);
+            EXPECT_EQ(res1, expect(in0));
+            EXPECT_EQ(a->getRawDataPtr<float *>(), in0.data());
+        }
+
+        // Re-preparing a plan leaves the graph's tensors to graph runs.
+        auto plan = runtime->compile(g, true);
+        plan->bind(out, res1.data());
+        std::atomic<bool> stop{false};
+        int mismatches = 0;
+        std::thread graphRuns(
+            [&]
+            {
+                const auto want = expect(in0);
+                while (!stop)
+                {
+                    runtime->run(g);
+                    mismatches += res0 != want;
+                }
+            });
+        for (int iter = 0; iter < 200; ++iter)
+        {
+            plan->bind(a, iter % 2 ? in0.data() : in1.data());
+            runtime->run(plan);
+            EXPECT_EQ(res1, expect(iter % 2 ? in0 : in1));
+        }
+        stop = true;
+        graphRuns.join();
+        EXPECT_EQ(mismatches, 0);
+    }
+
+    TEST(Runtime, NumaPlacement)
+    {
+        const auto &topology = NumaTopology::getInstance();
+        ASSERT_GE(topology.numNodes(), 1);
+        ASSERT_FALSE(topology.getCpus(0).empty());
+        EXPECT_EQ(topology.getNodeOfCpu(topology.getCpus(0)[0]), 0);
+
+        auto runtime = make_ref<NativeCpuRuntimeObj>();
+        EXPECT_THROW(runtime->setNumaNode(topology.numNodes()), Exception);
+        runtime->setNumaNode(0);
+        auto &memory = runtime->getMemoryProvider();
+        void *ptr = runtime->alloc(100000);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr) % memory.getAlignment(),
+                  0u);
+        // Binding fails without kernel NUMA support.
+        int node = memory.getNode(ptr);
+        EXPECT_TRUE(node == 0 || node == -1);
+        EXPECT_EQ(memory.getNodeUsage()[node], 100000u);
+        runtime->dealloc(ptr);
+        EXPECT_EQ(memory.getNodeUsage()[node], 0u);
+
+        Graph g = make_ref<GraphObj>(runtime);
+        auto a = g->addTensor({64, 65}, DataType::Float32);
+        auto add = g->addOp<AddObj>(a, a, nullptr);
+        g->dataMalloc();
+        a->setData(IncrementalGenerator());
+        auto affinity = []
+        {
+            vector<int> cpus;
+#ifdef __linux__
+            cpu_set_t set;
+            sched_getaffinity(0, sizeof(set), &set);
+            for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+                if (CPU_ISSET(cpu, &set))
+                    cpus.emplace_back(cpu);
+#endif
+            return cpus;
+        };
+        const auto callerCpus = affinity();
+#ifdef __linux__
+        EXPECT_EQ(topology.getProcessCpus(), callerCpus);
+#endif
+        runtime->setThreadPinning(true);
+        runtime->run(g);
+        runtime->setInterOpThreads(2);
+        runtime->run(g);
+        vector<float> expect(a->size());
+        for (size_t i = 0; i < expect.size(); ++i)
+            expect[i] = 2.f * i;
+        EXPECT_TRUE(add->getOutput()->equalData(expect));
+        // The caller keeps its affinity; pool workers get their slice.
+        EXPECT_EQ(affinity(), callerCpus);
+        EXPECT_TRUE(ThreadPool::getWorkerCpus().empty());
+        const int cpu = topology.getCpus(0)[0];
+        ThreadPool pool(2, {{cpu}});
+        std::promise<vector<int>> workerCpus;
+        pool.submit([&] { workerCpus.set_value(ThreadPool::getWorkerCpus()); });
+        auto pinned = workerCpus.get_future().get();
+        EXPECT_TRUE(pinned.empty() || pinned == vector<int>{cpu});
+        runtime->setThreadPinning(false);
+        runtime->setNumaNode(-1);
+        runtime->run(g);
+        EXPECT_TRUE(add->getOutput()->equalData(expect));
+#if defined(__linux__) && defined(_OPENMP)
+        // Unpinned, the team gets back the affinity the process started
+        // with, not every CPU of the host.
+        vector<vector<int>> teamCpus(runtime->getNumThreads());
+#pragma omp parallel num_threads(runtime->getNumThreads())
+        teamCpus[omp_get_thread_num()] = affinity();
+        for (auto &cpus : teamCpus)
+            EXPECT_EQ(cpus, callerCpus);
+#endif
+    }
+
+} // namespace infini
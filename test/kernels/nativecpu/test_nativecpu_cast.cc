@@ -0,0 +1,102 @@
+#include "core/graph.h"
+#include "core/runtime.h"
+#include "operators/unary.h"
+#include "utils/cpu_isa.h"
+#include "utils/fp16.h"
+
+#include "test.h"
+
+namespace infini {
+
+// Runs the cast under every ISA and compares the raw output against `expect`.
+template <typename From, typename To>
+void testCastNativeCpu(CastType type, DataType dtype, const vector<From> &in,
+                       const vector<To> &expect) {
+    Runtime runtime = NativeCpuRuntimeObj::getInstance();
+    Graph g = make_ref<GraphObj>(runtime);
+    auto t = g->addTensor({(int)in.size()}, dtype);
+    auto op = g->addOp<CastObj>(t, nullptr, type);
+    g->dataMalloc();
+    t->setData([&](void *ptr, size_t size, DataType) {
+        std::copy_n(in.data(), size, static_cast<From *>(ptr));
+    });
+
+    for (auto isa : {CpuIsa::Scalar, CpuIsa::SSE, CpuIsa::AVX2,
+                     CpuIsa::AVX512}) {
+        set_cpu_isa(isa);
+        runtime->run(g);
+        auto out = op->getOutput()->getRawDataPtr<To *>();
+        EXPECT_TRUE(std::equal(expect.begin(), expect.end(), out))
+            << cpu_isa_str(isa);
+    }
+    set_cpu_isa(detect_cpu_isa());
+}
+
+template <typename From, typename To>
+void testCastNativeCpu(CastType type, DataType dtype, const vector<From> &in) {
+    vector<To> expect(in.begin(), in.end());
+    testCastNativeCpu<From, To>(type, dtype, in, expect);
+}
+
+static vector<float> castInput(size_t n) {
+    vector<float> v(n);
+    for (size_t i = 0; i < n; ++i)
+        v[i] = (float)((int)(i * 37 % 255) - 127) * 0.75f;
+    return v;
+}
+
+TEST(Cast, NativeCpu) {
+    auto f = castInput(133);
+    testCastNativeCpu<float, int32_t>(CastType::Float2Int32,
+                                      DataType::Float32, f);
+    testCastNativeCpu<float, int8_t>(CastType::Float2Int8, DataType::Float32,
+                                     f);
+    testCastNativeCpu<float, int64_t>(CastType::Float2Int64,
+                                      DataType::Float32, f);
+    vector<int32_t> i32(f.begin(), f.end());
+    testCastNativeCpu<int32_t, float>(CastType::Int322Float, DataType::Int32,
+                                      i32);
+    testCastNativeCpu<int32_t, int16_t>(CastType::Int322Int16,
+                                        DataType::Int32, i32);
+    vector<int8_t> i8(f.begin(), f.end());
+    testCastNativeCpu<int8_t, int32_t>(CastType::Int82Int32, DataType::Int8,
+                                       i8);
+    vector<uint8_t> u8(i8.begin(), i8.end());
+    testCastNativeCpu<uint8_t, float>(CastType::Uint82Float, DataType::UInt8,
+                                      u8);
+    vector<int64_t> i64(f.begin(), f.end());
+    testCastNativeCpu<int64_t, float>(CastType::Int642Float, DataType::Int64,
+                                      i64);
+}
+
+TEST(Cast, NativeCpuHalf) {
+    // Values exercising rounding, subnormals, overflow and special values.
+    auto f = castInput(77);
+    for (float x : {1e-7f, -3e-6f, 6e-8f, 65519.f, 65520.f, 1e10f, -0.f,
+                    1.f / 3, std::numeric_limits<float>::infinity(),
+                    std::numeric_limits<float>::quiet_NaN(), 1e-40f})
+        f.emplace_back(x);
+
+    vector<uint16_t> h(f.size()), b(f.size());
+    std::transform(f.begin(), f.end(), h.begin(), float_to_fp16);
+    std::transform(f.begin(), f.end(), b.begin(), float_to_bf16);
+    testCastNativeCpu<float, uint16_t>(CastType::Float2Float16,
+                                       DataType::Float32, f, h);
+    testCastNativeCpu<float, uint16_t>(CastType::Float2BFloat16,
+                                       DataType::Float32, f, b);
+
+    // Widening is exact, compare bit patterns so nans match too.
+    vector<uint32_t> hf(h.size()), bf(b.size());
+    for (size_t i = 0; i < h.size(); ++i) {
+        hf[i] = float_as_bits(fp16_to_float(h[i]));
+        bf[i] = float_as_bits(bf16_to_float(b[i]));
+    }
+    testCastNativeCpu<uint16_t, uint32_t>(CastType::Float162Float,
+                                          DataType::Float16, h, hf);
+    testCastNativeCpu<uint16_t, uint32_t>(CastType::BFloat162Float,
+                                          DataType::BFloat16, b, bf);
+    EXPECT_EQ(fp16_to_float(float_to_fp16(1.f / 3)), 0.333251953125f);
+    EXPECT_EQ(bf16_to_float(float_to_bf16(1.f / 3)), 0.333984375f);
+}
+
+} // namespace infini
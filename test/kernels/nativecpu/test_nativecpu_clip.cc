@@ -0,0 +1,153 @@
+#include "core/graph.h"
+#include "core/runtime.h"
+#include "operators/unary.h"
+#include "utils/cpu_isa.h"
+#include "utils/fp16.h"
+
+#include "test.h"
+
+namespace infini {
+
+template <typename T>
+void testClipNativeCpu(DataType dtype, const vector<T> &in,
+                       std::optional<float> min, std::optional<float> max,
+                       bool relu, const vector<T> &expect) {
+    Runtime runtime = NativeCpuRuntimeObj::getInstance();
+    Graph g = make_ref<GraphObj>(runtime);
+    auto t = g->addTensor({(int)in.size()}, dtype);
+    Tensor out = relu ? g->addOp<ReluObj>(t, nullptr)->getOutput()
+                      : g->addOp<ClipObj>(t, nullptr, min, max)->getOutput();
+    g->dataMalloc();
+    t->setData([&](void *ptr, size_t size, DataType) {
+        std::copy_n(in.data(), size, static_cast<T *>(ptr));
+    });
+
+    for (auto isa : {CpuIsa::Scalar, CpuIsa::SSE, CpuIsa::AVX2,
+                     CpuIsa::AVX512}) {
+        set_cpu_isa(isa);
+        runtime->run(g);
+        auto ptr = out->getRawDataPtr<T *>();
+        EXPECT_TRUE(std::equal(expect.begin(), expect.end(), ptr))
+            << cpu_isa_str(isa);
+    }
+    set_cpu_isa(detect_cpu_isa());
+}
+
+// Clips `in` element by element with the scalar definition and checks the
+// kernel against it.
+template <typename T>
+void testClipNativeCpu(DataType dtype, const vector<T> &in,
+                       std::optional<float> min, std::optional<float> max) {
+    vector<T> expect(in.size());
+    for (size_t i = 0; i < in.size(); ++i) {
+        double v = in[i];
+        expect[i] = in[i];
+        if (min && v < *min)
+            expect[i] = T(std::ceil(*min));
+        if (max && v > *max)
+            expect[i] = T(std::floor(*max));
+    }
+    testClipNativeCpu(dtype, in, min, max, false, expect);
+}
+
+TEST(Clip, NativeCpu) {
+    vector<float> f(131);
+    for (size_t i = 0; i < f.size(); ++i)
+        f[i] = (float)((int)(i * 37 % 101) - 50) * 0.5f;
+    testClipNativeCpu(DataType::Float32, f, -3.f, 7.f);
+    testClipNativeCpu(DataType::Float32, f, -3.f, std::nullopt);
+    testClipNativeCpu(DataType::Float32, f, std::nullopt, 7.f);
+    testClipNativeCpu(DataType::Float32, f, std::nullopt, std::nullopt);
+
+    vector<int8_t> i8(f.begin(), f.end());
+    testClipNativeCpu(DataType::Int8, i8, -3.5f, 7.5f);
+    testClipNativeCpu(DataType::Int8, i8, -1000.f, 1000.f);
+    vector<int32_t> i32(f.begin(), f.end());
+    testClipNativeCpu(DataType::Int32, i32, std::nullopt, 2.f);
+    vector<int64_t> i64(f.begin(), f.end());
+    testClipNativeCpu(DataType::Int64, i64, -7.f, 9.f);
+
+    // Bounds beyond the range of T saturate instead of wrapping.
+    constexpr float huge = std::numeric_limits<float>::max();
+    i32.insert(i32.end(), {std::numeric_limits<int32_t>::max(),
+                           std::numeric_limits<int32_t>::min()});
+    testClipNativeCpu(DataType::Int32, i32, -huge, huge);
+    testClipNativeCpu(DataType::Int32, i32, -huge, 3.f);
+    vector<uint32_t> u32;
+    for (size_t i = 0; i < f.size(); ++i)
+        u32.emplace_back(uint32_t(i) << (i % 32));
+    testClipNativeCpu(DataType::UInt32, u32, -huge, huge);
+    testClipNativeCpu(DataType::UInt32, u32, -1.f, 0x1p20f);
+    i64.insert(i64.end(), {std::numeric_limits<int64_t>::max(),
+                           std::numeric_limits<int64_t>::min()});
+    testClipNativeCpu(DataType::Int64, i64, -huge, huge);
+    testClipNativeCpu(DataType::Int64, i64, std::nullopt, huge);
+    testClipNativeCpu(DataType::Int64, i64, -huge, 3.f);
+    testClipNativeCpu(DataType::Int64, i64, 0x1p62f, std::nullopt);
+    vector<uint64_t> u64;
+    for (size_t i = 0; i < f.size(); ++i)
+        u64.emplace_back(uint64_t(i) << (i % 64));
+    u64.emplace_back(std::numeric_limits<uint64_t>::max());
+    testClipNativeCpu(DataType::UInt64, u64, -huge, huge);
+    testClipNativeCpu(DataType::UInt64, u64, std::nullopt, huge);
+    testClipNativeCpu(DataType::UInt64, u64, -1.f, 0x1p40f);
+    testClipNativeCpu(DataType::UInt64, u64, 0x1p63f, std::nullopt);
+}
+
+TEST(Relu, NativeCpu) {
+    vector<float> f{-2, -0.5, 0, 1, 3, -7, 8, 9, -1, 2, -3, 4, 5, -6, 7, 1,
+                    -5, 6, std::numeric_limits<float>::quiet_NaN()};
+    vector<float> expect(f.size());
+    for (size_t i = 0; i < f.size(); ++i)
+        expect[i] = f[i] < 0 ? 0 : f[i];
+    vector<uint32_t> fBits(f.size()), expectBits(f.size());
+    std::transform(f.begin(), f.end(), fBits.begin(), float_as_bits);
+    std::transform(expect.begin(), expect.end(), expectBits.begin(),
+                   float_as_bits);
+    // Compared as bits so that the nan is checked as well.
+    testClipNativeCpu(DataType::Float32, fBits, std::nullopt, std::nullopt,
+                      true, expectBits);
+
+    vector<int8_t> i8(f.begin(), f.end() - 1), i8Expect;
+    for (int8_t x : i8)
+        i8Expect.emplace_back(std::max<int8_t>(x, 0));
+    testClipNativeCpu(DataType::Int8, i8, std::nullopt, std::nullopt, true,
+                      i8Expect);
+
+    // Half values, including -0, infinities and nans.
+    vector<uint16_t> h, hExpect;
+    for (float x : f)
+        h.emplace_back(float_to_fp16(x));
+    for (uint16_t x : {0x8000, 0xfc00, 0x7c00, 0x7e00, 0xfe00, 0x0001, 0x8001})
+        h.emplace_back(x);
+    for (uint16_t x : h) {
+        float v = fp16_to_float(x);
+        hExpect.emplace_back(std::isnan(v) ? x : float_to_fp16(v > 0 ? v : 0));
+    }
+    testClipNativeCpu(DataType::Float16, h, std::nullopt, std::nullopt, true,
+                      hExpect);
+}
+
+TEST(Clip, NativeCpuHalf) {
+    vector<uint16_t> h, hExpect;
+    for (int i = -40; i < 40; ++i)
+        h.emplace_back(float_to_fp16(i * 0.25f));
+    for (uint16_t x : h) {
+        float v = fp16_to_float(x);
+        hExpect.emplace_back(float_to_fp16(std::min(std::max(v, -2.5f), 6.f)));
+    }
+    testClipNativeCpu(DataType::Float16, h, -2.5f, 6.f, false, hExpect);
+
+    vector<uint16_t> b, bExpect;
+    for (int i = -40; i < 40; ++i)
+        b.emplace_back(float_to_bf16(i * 0.25f));
+    b.emplace_back(0x7fc0);
+    for (uint16_t x : b) {
+        float v = bf16_to_float(x);
+        bExpect.emplace_back(std::isnan(v) ? x : float_to_bf16(std::min(v, 3.f)));
+    }
+    testClipNativeCpu(DataType::BFloat16, b, std::nullopt, 3.f, false,
+                      bExpect);
+}
+
+} // namespace infini
@@ -25,4 +25,46 @@ TEST(Concat, NativeCpu) {
                       6, 7, 8, 1, 1, 1, 9, 10, 11, 1, 1, 1}));
 }
 
+template <typename T>
+void testConcatNativeCpu(DataType dtype, const vector<Shape> &shapes,
+                         int dim) {
+    Runtime runtime = NativeCpuRuntimeObj::getInstance();
+    Graph g = make_ref<GraphObj>(runtime);
+    TensorVec inputs;
+    for (auto &shape : shapes)
+        inputs.emplace_back(g->addTensor(shape, dtype));
+    auto op = g->addOp<ConcatObj>(inputs, nullptr, dim);
+    g->dataMalloc();
+    for (size_t i = 0; i < inputs.size(); ++i)
+        inputs[i]->setData([i](void *ptr, size_t size, DataType) {
+            for (size_t j = 0; j < size; ++j)
+                static_cast<T *>(ptr)[j] = T(i * 1000 + j % 997);
+        });
+
+    size_t outer = 1;
+    for (int d = 0; d < dim; ++d)
+        outer *= shapes[0][d];
+    vector<T> expect;
+    for (size_t o = 0; o < outer; ++o)
+        for (size_t i = 0; i < shapes.size(); ++i) {
+            size_t slab = inputs[i]->size() / outer;
+            for (size_t j = o * slab; j < (o + 1) * slab; ++j)
+                expect.emplace_back(T(i * 1000 + j % 997));
+        }
+
+    runtime->run(g);
+    EXPECT_TRUE(op->getOutput()->equalData(expect));
+}
+
+TEST(Concat, NativeCpuSlab) {
+    testConcatNativeCpu<int8_t>(DataType::Int8, {{2, 3, 5}, {2, 1, 5}}, 1);
+    testConcatNativeCpu<int64_t>(DataType::Int64,
+                                 {{3, 2, 4}, {3, 2, 1}, {3, 2, 7}}, 2);
+    testConcatNativeCpu<uint16_t>(DataType::Float16, {{2, 6}, {5, 6}}, 0);
+    // Large enough for chunked, non-temporal copies.
+    testConcatNativeCpu<float>(DataType::Float32,
+                               {{2, 1 << 20, 1}, {2, 3, 1}, {2, 1 << 19, 1}},
+                               1);
+}
+
 } // namespace infini
@@ -1,6 +1,8 @@
 #include "core/graph.h"
 #include "core/runtime.h"
 #include "operators/element_wise.h"
+#include "utils/cpu_isa.h"
+#include "utils/fp16.h"
 
 #include "test.h"
 
@@ -41,4 +43,153 @@ TEST(ElementWise, NativeCpu) {
         Shape{2, 1, 1}, ExpectOutput{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11});
 }
 
+TEST(ElementWise, NativeCpuBroadcastFastPaths) {
+    // same shape
+    testElementWiseNativeCpu<AddObj>(
+        IncrementalGenerator(), IncrementalGenerator(), Shape{2, 3},
+        Shape{2, 3}, ExpectOutput{0, 2, 4, 6, 8, 10});
+    // scalar
+    testElementWiseNativeCpu<SubObj>(IncrementalGenerator(), OneGenerator(),
+                                     Shape{2, 3}, Shape{1},
+                                     ExpectOutput{-1, 0, 1, 2, 3, 4});
+    testElementWiseNativeCpu<SubObj>(OneGenerator(), IncrementalGenerator(),
+                                     Shape{}, Shape{2, 3},
+                                     ExpectOutput{1, 0, -1, -2, -3, -4});
+    // row
+    testElementWiseNativeCpu<MulObj>(
+        IncrementalGenerator(), IncrementalGenerator(), Shape{2, 3}, Shape{3},
+        ExpectOutput{0, 1, 4, 0, 4, 10});
+    // column
+    testElementWiseNativeCpu<AddObj>(
+        IncrementalGenerator(), IncrementalGenerator(), Shape{2, 3},
+        Shape{2, 1}, ExpectOutput{0, 1, 2, 4, 5, 6});
+    // both sides broadcast
+    testElementWiseNativeCpu<AddObj>(
+        IncrementalGenerator(), IncrementalGenerator(), Shape{2, 1, 3},
+        Shape{1, 2, 1}, ExpectOutput{0, 1, 2, 1, 2, 3, 3, 4, 5, 4, 5, 6});
+}
+
+// Index into an input of `shape` read by element `idx` of a broadcast
+// output of `outShape`, computed from the coordinates of the element.
+static size_t broadcastIndex(const Shape &outShape, const Shape &shape,
+                             size_t idx) {
+    size_t inIdx = 0, inStride = 1;
+    for (size_t d = outShape.size(); d-- > 0;) {
+        const size_t coord = idx % outShape[d];
+        idx /= outShape[d];
+        const size_t k = outShape.size() - d;
+        if (k > shape.size())
+            continue;
+        const size_t dim = shape[shape.size() - k];
+        inIdx += (dim == 1 ? 0 : coord) * inStride;
+        inStride *= dim;
+    }
+    return inIdx;
+}
+
+template <typename T>
+void testElementWiseSimd(DataType dtype, const Shape &shape1,
+                         const Shape &shape2) {
+    Runtime runtime = NativeCpuRuntimeObj::getInstance();
+    Graph g = make_ref<GraphObj>(runtime);
+    auto t1 = g->addTensor(shape1, dtype);
+    auto t2 = g->addTensor(shape2, dtype);
+    auto add = g->addOp<AddObj>(t1, t2, nullptr);
+    auto mul = g->addOp<MulObj>(t1, t2, nullptr);
+    auto div = g->addOp<DivObj>(t1, t2, nullptr);
+    g->dataMalloc();
+    auto fill = [](void *ptr, size_t size, DataType) {
+        for (size_t i = 0; i < size; ++i)
+            static_cast<T *>(ptr)[i] = T(i % 7 + 1);
+    };
+    t1->setData(fill);
+    t2->setData(fill);
+
+    const auto outShape = add->getOutput()->getDims();
+    vector<T> expAdd(add->getOutput()->size()), expMul(expAdd.size()),
+        expDiv(expAdd.size());
+    for (size_t o = 0; o < expAdd.size(); ++o) {
+        T a = T(broadcastIndex(outShape, shape1, o) % 7 + 1);
+        T b = T(broadcastIndex(outShape, shape2, o) % 7 + 1);
+        expAdd[o] = a + b;
+        expMul[o] = a * b;
+        expDiv[o] = a / b;
+    }
+
+    for (auto isa : {CpuIsa::Scalar, CpuIsa::SSE, CpuIsa::AVX2,
+                     CpuIsa::AVX512}) {
+        set_cpu_isa(isa);
+        runtime->run(g);
+        EXPECT_TRUE(add->getOutput()->equalData(expAdd)) << cpu_isa_str(isa);
+        EXPECT_TRUE(mul->getOutput()->equalData(expMul)) << cpu_isa_str(isa);
+        EXPECT_TRUE(div->getOutput()->equalData(expDiv)) << cpu_isa_str(isa);
+    }
+    set_cpu_isa(detect_cpu_isa());
+}
+
+TEST(ElementWise, NativeCpuSimd) {
+    testElementWiseSimd<float>(DataType::Float32, {3, 67}, {3, 67});
+    testElementWiseSimd<float>(DataType::Float32, {5, 133}, {133});
+    testElementWiseSimd<int8_t>(DataType::Int8, {2, 131}, {2, 131});
+    testElementWiseSimd<int16_t>(DataType::Int16, {1}, {70});
+    testElementWiseSimd<int32_t>(DataType::Int32, {4, 37}, {4, 1});
+    testElementWiseSimd<int64_t>(DataType::Int64, {2, 3, 41}, {3, 41});
+    testElementWiseSimd<uint32_t>(DataType::UInt32, {100}, {100});
+    testElementWiseSimd<double>(DataType::Double, {3, 19}, {19});
+}
+
+// Float16 and BFloat16 are computed in float and rounded once.
+static void testElementWiseHalf(DataType dtype, const Shape &shape1,
+                                const Shape &shape2) {
+    const bool fp16 = dtype == DataType::Float16;
+    auto toFloat = [&](uint16_t x) {
+        return fp16 ? fp16_to_float(x) : bf16_to_float(x);
+    };
+    auto toHalf = [&](float x) {
+        return fp16 ? float_to_fp16(x) : float_to_bf16(x);
+    };
+    Runtime runtime = NativeCpuRuntimeObj::getInstance();
+    Graph g = make_ref<GraphObj>(runtime);
+    auto t1 = g->addTensor(shape1, dtype);
+    auto t2 = g->addTensor(shape2, dtype);
+    auto sub = g->addOp<SubObj>(t1, t2, nullptr);
+    auto div = g->addOp<DivObj>(t1, t2, nullptr);
+    g->dataMalloc();
+    auto fill = [&](void *ptr, size_t size, DataType) {
+        for (size_t i = 0; i < size; ++i)
+            static_cast<uint16_t *>(ptr)[i] = toHalf((i % 11 + 1) * 0.3f);
+    };
+    t1->setData(fill);
+    t2->setData(fill);
+
+    const auto outShape = sub->getOutput()->getDims();
+    vector<uint16_t> expSub(sub->getOutput()->size()), expDiv(expSub.size());
+    for (size_t o = 0; o < expSub.size(); ++o) {
+        float a = toFloat(
+            toHalf((broadcastIndex(outShape, shape1, o) % 11 + 1) * 0.3f));
+        float b = toFloat(
+            toHalf((broadcastIndex(outShape, shape2, o) % 11 + 1) * 0.3f));
+        expSub[o] = toHalf(a - b);
+        expDiv[o] = toHalf(a / b);
+    }
+
+    for (auto isa : {CpuIsa::Scalar, CpuIsa::AVX512}) {
+        set_cpu_isa(isa);
+        runtime->run(g);
+        EXPECT_TRUE(std::equal(expSub.begin(), expSub.end(),
+                               sub->getOutput()->getRawDataPtr<uint16_t *>()))
+            << cpu_isa_str(isa);
+        EXPECT_TRUE(std::equal(expDiv.begin(), expDiv.end(),
+                               div->getOutput()->getRawDataPtr<uint16_t *>()))
+            << cpu_isa_str(isa);
+    }
+    set_cpu_isa(detect_cpu_isa());
+}
+
+TEST(ElementWise, NativeCpuHalf) {
+    testElementWiseHalf(DataType::Float16, {3, 300}, {3, 300});
+    testElementWiseHalf(DataType::Float16, {1}, {2, 70});
+    testElementWiseHalf(DataType::BFloat16, {4, 37}, {4, 1});
+}
+
 } // namespace infini
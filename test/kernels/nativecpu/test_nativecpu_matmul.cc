@@ -0,0 +1,106 @@
+#include "core/graph.h"
+#include "core/kernel.h"
+#include "core/runtime.h"
+#include "operators/matmul.h"
+
+#include "test.h"
+
+namespace infini {
+
+// Reference matmul on plain vectors, broadcasting leading dims like numpy.
+static vector<float> refMatmul(const vector<float> &a, const Shape &shapeA,
+                               const vector<float> &b, const Shape &shapeB,
+                               const Shape &shapeC, bool transA, bool transB) {
+    int rank = shapeC.size();
+    int m = shapeC[rank - 2], n = shapeC[rank - 1];
+    int k = transA ? shapeA[shapeA.size() - 2] : shapeA.back();
+    size_t batch = 1;
+    for (int i = 0; i < rank - 2; ++i)
+        batch *= shapeC[i];
+    auto batchOffset = [&](const Shape &shape, size_t idx) {
+        size_t off = 0, stride = 1;
+        for (int i = rank - 3, j = shape.size() - 3; i >= 0; --i, --j) {
+            size_t pos = idx % shapeC[i];
+            idx /= shapeC[i];
+            if (j >= 0 && shape[j] != 1)
+                off += pos * stride;
+            if (j >= 0)
+                stride *= shape[j];
+        }
+        return off;
+    };
+    vector<float> c(batch * m * n);
+    for (size_t bt = 0; bt < batch; ++bt) {
+        const float *pa = a.data() + batchOffset(shapeA, bt) * m * k;
+        const float *pb = b.data() + batchOffset(shapeB, bt) * k * n;
+        for (int i = 0; i < m; ++i)
+            for (int j = 0; j < n; ++j) {
+                float sum = 0;
+                for (int p = 0; p < k; ++p)
+                    sum += (transA ? pa[p * m + i] : pa[i * k + p]) *
+                           (transB ? pb[j * k + p] : pb[p * n + j]);
+                c[bt * m * n + i * n + j] = sum;
+            }
+    }
+    return c;
+}
+
+static void testMatmulNativeCpu(
+    const Shape &shapeA, const Shape &shapeB, bool transA, bool transB,
+    Runtime runtime = NativeCpuRuntimeObj::getInstance()) {
+    Graph g = make_ref<GraphObj>(runtime);
+    auto A = g->addTensor(shapeA, DataType::Float32);
+    auto B = g->addTensor(shapeB, DataType::Float32);
+    auto op = g->addOp<MatmulObj>(A, B, nullptr, transA, transB);
+    g->dataMalloc();
+    auto gen = [](void *ptr, size_t size, DataType) {
+        auto data = static_cast<float *>(ptr);
+        for (size_t i = 0; i < size; ++i)
+            data[i] = (float)((i * 7) % 13) - 6.f;
+    };
+    A->setData(gen);
+    B->setData(gen);
+
+    runtime->run(g);
+
+    vector<float> a(A->size()), b(B->size());
+    gen(a.data(), a.size(), DataType::Float32);
+    gen(b.data(), b.size(), DataType::Float32);
+    auto C = op->getOutput();
+    EXPECT_TRUE(C->equalData(refMatmul(a, shapeA, b, shapeB, C->getDims(),
+                                       transA, transB)));
+}
+
+TEST(Matmul, NativeCpu) {
+    Runtime runtime = NativeCpuRuntimeObj::getInstance();
+    Graph g = make_ref<GraphObj>(runtime);
+    auto A = g->addTensor({1, 2, 3}, DataType::Float32);
+    auto B = g->addTensor({1, 3, 2}, DataType::Float32);
+    auto op = g->addOp<MatmulObj>(A, B, nullptr);
+    g->dataMalloc();
+    A->setData(IncrementalGenerator());
+    B->setData(IncrementalGenerator());
+
+    runtime->run(g);
+    EXPECT_TRUE(op->getOutput()->equalData(vector<float>{10, 13, 28, 40}));
+}
+
+TEST(Matmul, NativeCpuTransposeAndBroadcast) {
+    testMatmulNativeCpu({7, 5}, {5, 19}, false, false);
+    testMatmulNativeCpu({2, 3, 13, 300}, {1, 3, 300, 33}, false, false);
+    testMatmulNativeCpu({2, 3, 300, 13}, {3, 300, 33}, true, false);
+    testMatmulNativeCpu({2, 3, 13, 300}, {1, 1, 33, 300}, false, true);
+    testMatmulNativeCpu({3, 300, 13}, {2, 1, 33, 300}, true, true);
+    testMatmulNativeCpu({4, 100, 17}, {17, 4100}, false, false);
+}
+
+TEST(Matmul, NativeCpuBatchedThreads) {
+    // Batches of few rows are shared out over products and panels of B.
+    auto runtime = make_ref<NativeCpuRuntimeObj>();
+    runtime->setNumThreads(4);
+    testMatmulNativeCpu({9, 5, 64}, {9, 64, 300}, false, false, runtime);
+    testMatmulNativeCpu({3, 2, 300}, {3, 4100, 300}, false, true, runtime);
+    testMatmulNativeCpu({2, 40, 150}, {2, 40, 50}, true, false, runtime);
+}
+
+} // namespace infini
@@ -2,6 +2,7 @@
 #include "core/kernel.h"
 #include "core/runtime.h"
 #include "operators/transpose.h"
+#include "utils/cpu_isa.h"
 
 #include "test.h"
 
@@ -24,4 +25,59 @@ TEST(Transpose, NativeCpu) {
                                                           8, 9, 10, 11, 20, 21, 22, 23}));
 }
 
+template <typename T>
+void testTransposeNativeCpu(DataType dtype, const Shape &shape,
+                            const vector<int> &permute) {
+    Runtime runtime = NativeCpuRuntimeObj::getInstance();
+    Graph g = make_ref<GraphObj>(runtime);
+    auto input = g->addTensor(shape, dtype);
+    auto op = g->addOp<TransposeObj>(input, nullptr, permute);
+    g->dataMalloc();
+    input->setData([](void *ptr, size_t size, DataType) {
+        for (size_t i = 0; i < size; ++i)
+            static_cast<T *>(ptr)[i] = T(i);
+    });
+
+    // Reference: walk the output and gather from the input.
+    auto outDims = op->getOutput()->getDims();
+    int rank = shape.size();
+    vector<size_t> inStride(rank);
+    for (int d = rank - 1, s = 1; d >= 0; s *= shape[d--])
+        inStride[d] = s;
+    vector<T> expect(input->size());
+    for (size_t o = 0; o < expect.size(); ++o) {
+        size_t rest = o, inIdx = 0;
+        for (int j = rank - 1; j >= 0; --j) {
+            inIdx += rest % outDims[j] * inStride[permute[j]];
+            rest /= outDims[j];
+        }
+        expect[o] = T(inIdx);
+    }
+
+    for (auto isa : {CpuIsa::Scalar, CpuIsa::AVX2}) {
+        set_cpu_isa(isa);
+        runtime->run(g);
+        EXPECT_TRUE(op->getOutput()->equalData(expect))
+            << vecToString(shape) << vecToString(permute);
+    }
+    set_cpu_isa(detect_cpu_isa());
+}
+
+TEST(Transpose, NativeCpuTiled) {
+    testTransposeNativeCpu<float>(DataType::Float32, {2, 37, 70}, {0, 2, 1});
+    testTransposeNativeCpu<float>(DataType::Float32, {64, 40}, {1, 0});
+    testTransposeNativeCpu<float>(DataType::Float32, {2, 5, 3, 7, 1},
+                                  {3, 1, 4, 0, 2});
+    testTransposeNativeCpu<float>(DataType::Float32, {2, 9, 4, 16},
+                                  {0, 2, 1, 3});
+    testTransposeNativeCpu<float>(DataType::Float32, {3, 4, 5}, {0, 1, 2});
+    testTransposeNativeCpu<int8_t>(DataType::Int8, {3, 50, 41}, {2, 0, 1});
+    testTransposeNativeCpu<int16_t>(DataType::Int16, {33, 2, 17},
+                                    {1, 2, 0});
+    testTransposeNativeCpu<int64_t>(DataType::Int64, {4, 5, 6, 7},
+                                    {3, 2, 1, 0});
+    testTransposeNativeCpu<uint32_t>(DataType::UInt32, {2, 3, 4, 5, 6},
+                                     {0, 3, 4, 1, 2});
+}
+
 } // namespace infini